@@ -651,7 +651,7 @@ AutoType::parseSequence(const QString& entrySequence, const Entry* entry, QStrin
                 continue;
             }
             // Show pickchars dialog for entry's password
-            auto password = entry->resolvePlaceholder(entry->password());
+            auto password = entry->resolvedPassword();
             if (!password.isEmpty()) {
                 PickcharsDialog pickcharsDialog(password);
                 if (pickcharsDialog.exec() == QDialog::Accepted && !pickcharsDialog.selectedChars().isEmpty()) {
@@ -126,9 +126,9 @@ QVariant AutoTypeMatchModel::data(const QModelIndex& index, int role) const
             }
             break;
         case Title:
-            return match.first->resolveMultiplePlaceholders(match.first->title());
+            return match.first->resolvedTitle();
         case Username:
-            return match.first->resolveMultiplePlaceholders(match.first->username());
+            return match.first->resolvedUsername();
         case Sequence:
             return match.second;
         }
@@ -333,14 +333,14 @@ void AutoTypeSelectDialog::buildActionMenu()
     connect(copyUsernameAction, &QAction::triggered, this, [&] {
         auto entry = m_ui->view->currentMatch().first;
         if (entry) {
-            clipboard()->setText(entry->resolvePlaceholder(entry->username()));
+            clipboard()->setText(entry->resolvedUsername());
             reject();
         }
     });
     connect(copyPasswordAction, &QAction::triggered, this, [&] {
         auto entry = m_ui->view->currentMatch().first;
         if (entry) {
-            clipboard()->setText(entry->resolvePlaceholder(entry->password()));
+            clipboard()->setText(entry->resolvedPassword());
             reject();
         }
     });
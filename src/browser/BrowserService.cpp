@@ -671,6 +671,30 @@ BrowserService::searchEntries(const QSharedPointer<Database>& db, const QString&
         return entries;
     }
 
+    // Entries can only match URLs with the same base domain, special URLs are matched by a full scan
+    QList<Entry*> candidates;
+    if (siteUrlStr.startsWith("keepassxc://") || siteUrlStr.startsWith("file://")) {
+        candidates = browserEntries(rootGroup);
+    } else {
+        candidates = hostIndex(db).value(getTopLevelDomainFromUrl(QUrl(siteUrlStr).host()));
+    }
+
+    for (auto* entry : asConst(candidates)) {
+        if (entryMatchesUrl(entry, siteUrlStr, formUrlStr)) {
+            entries.append(entry);
+        }
+    }
+
+    return entries;
+}
+
+/**
+ * Returns the entries of the group and its children that are not hidden
+ * from the browser extension, in tree order.
+ */
+QList<Entry*> BrowserService::browserEntries(Group* rootGroup)
+{
+    QList<Entry*> entries;
     for (const auto& group : rootGroup->groupsRecursive(true)) {
         if (group->isRecycled()
             || group->resolveCustomDataTriState(BrowserService::OPTION_HIDE_ENTRY) == Group::Enable) {
@@ -683,28 +707,72 @@ BrowserService::searchEntries(const QSharedPointer<Database>& db, const QString&
                     && entry->customData()->value(BrowserService::OPTION_HIDE_ENTRY) == TRUE_STR)) {
                 continue;
             }
+            entries.append(entry);
+        }
+    }
+    return entries;
+}
 
-            // Search for additional URL's starting with KP2A_URL
-            for (const auto& key : entry->attributes()->keys()) {
-                if (key.startsWith(ADDITIONAL_URL) && handleURL(entry->attributes()->value(key), siteUrlStr, formUrlStr)
-                    && !entries.contains(entry)) {
-                    entries.append(entry);
-                    continue;
-                }
+bool BrowserService::entryMatchesUrl(Entry* entry, const QString& siteUrlStr, const QString& formUrlStr)
+{
+    // Search for additional URL's starting with KP2A_URL
+    for (const auto& key : entry->attributes()->keys()) {
+        if (key.startsWith(ADDITIONAL_URL) && handleURL(entry->attributes()->value(key), siteUrlStr, formUrlStr)) {
+            return true;
+        }
+    }
+    return handleEntry(entry, siteUrlStr, formUrlStr);
+}
+
+/**
+ * Returns the browser entries of the database by the base domain of their URL
+ * and additional URLs. The index is rebuilt after the database was modified.
+ */
+const QHash<QString, QList<Entry*>>& BrowserService::hostIndex(const QSharedPointer<Database>& db)
+{
+    const int generation = db->placeholderGeneration();
+    auto cached = m_hostIndexes.constFind(db.data());
+    if (cached != m_hostIndexes.constEnd() && cached->database == db.data() && cached->generation == generation) {
+        return cached->entries;
+    }
+
+    // Drop the indexes of closed databases
+    for (auto it = m_hostIndexes.begin(); it != m_hostIndexes.end();) {
+        if (!it->database) {
+            it = m_hostIndexes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto& index = m_hostIndexes[db.data()];
+    index.database = db.data();
+    index.generation = generation;
+    index.entries.clear();
+
+    for (auto* entry : browserEntries(db->rootGroup())) {
+        QStringList urls{entry->url()};
+        for (const auto& key : entry->attributes()->keys()) {
+            if (key.startsWith(ADDITIONAL_URL)) {
+                urls.append(entry->attributes()->value(key));
             }
+        }
 
-            if (!handleEntry(entry, siteUrlStr, formUrlStr)) {
+        for (const auto& url : asConst(urls)) {
+            // Same interpretation of the entry URL as in handleURL()
+            const QUrl entryQUrl = url.contains("://") ? QUrl(url) : QUrl::fromUserInput(url);
+            if (url.isEmpty() || entryQUrl.host().isEmpty()) {
                 continue;
             }
 
-            // Additional URL check may have already inserted the entry to the list
-            if (!entries.contains(entry)) {
-                entries.append(entry);
+            auto& hostEntries = index.entries[getTopLevelDomainFromUrl(entryQUrl.host())];
+            if (hostEntries.isEmpty() || hostEntries.last() != entry) {
+                hostEntries.append(entry);
             }
         }
     }
 
-    return entries;
+    return index.entries;
 }
 
 QList<Entry*>
@@ -738,13 +806,10 @@ BrowserService::searchEntries(const QString& siteUrlStr, const QString& formUrlS
     }
 
     // Search entries matching the hostname
-    QString hostname = QUrl(siteUrlStr).host();
     QList<Entry*> entries;
-    do {
-        for (const auto& db : databases) {
-            entries << searchEntries(db, siteUrlStr, formUrlStr);
-        }
-    } while (entries.isEmpty() && removeFirstDomain(hostname));
+    for (const auto& db : databases) {
+        entries << searchEntries(db, siteUrlStr, formUrlStr);
+    }
 
     return entries;
 }
@@ -917,9 +982,9 @@ QList<Entry*> BrowserService::confirmEntries(QList<Entry*>& pwEntriesToConfirm,
 QJsonObject BrowserService::prepareEntry(const Entry* entry)
 {
     QJsonObject res;
-    res["login"] = entry->resolveMultiplePlaceholders(entry->username());
-    res["password"] = entry->resolveMultiplePlaceholders(entry->password());
-    res["name"] = entry->resolveMultiplePlaceholders(entry->title());
+    res["login"] = entry->resolvedUsername();
+    res["password"] = entry->resolvedPassword();
+    res["name"] = entry->resolvedTitle();
     res["uuid"] = entry->resolveMultiplePlaceholders(entry->uuidToHex());
     res["group"] = entry->resolveMultiplePlaceholders(entry->group()->name());
 
@@ -1089,23 +1154,6 @@ bool BrowserService::isIpAddress(const QString& host) const
     return address.protocol() == QAbstractSocket::IPv4Protocol || address.protocol() == QAbstractSocket::IPv6Protocol;
 }
 
-bool BrowserService::removeFirstDomain(QString& hostname)
-{
-    int pos = hostname.indexOf(".");
-    if (pos < 0) {
-        return false;
-    }
-
-    // Don't remove the second-level domain if it's the only one
-    if (hostname.count(".") > 1) {
-        hostname = hostname.mid(pos + 1);
-        return !hostname.isEmpty();
-    }
-
-    // Nothing removed
-    return false;
-}
-
 /* Test if a search URL matches a custom entry. If the URL has the schema "keepassxc", some special checks will be made.
  * Otherwise, this simply delegates to handleURL(). */
 bool BrowserService::handleEntry(Entry* entry, const QString& url, const QString& submitUrl)
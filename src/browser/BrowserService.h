@@ -131,6 +131,9 @@ private:
     QList<Entry*>
     searchEntries(const QSharedPointer<Database>& db, const QString& siteUrlStr, const QString& formUrlStr);
     QList<Entry*> searchEntries(const QString& siteUrlStr, const QString& formUrlStr, const StringPairList& keyList);
+    QList<Entry*> browserEntries(Group* rootGroup);
+    bool entryMatchesUrl(Entry* entry, const QString& siteUrlStr, const QString& formUrlStr);
+    const QHash<QString, QList<Entry*>>& hostIndex(const QSharedPointer<Database>& db);
     QList<Entry*> sortEntries(QList<Entry*>& pwEntries, const QString& siteUrlStr, const QString& formUrlStr);
     QList<Entry*> confirmEntries(QList<Entry*>& pwEntriesToConfirm,
                                  const QString& siteUrlStr,
@@ -145,7 +148,6 @@ private:
     int sortPriority(const QStringList& urls, const QString& siteUrlStr, const QString& formUrlStr);
     bool schemeFound(const QString& url);
     bool isIpAddress(const QString& host) const;
-    bool removeFirstDomain(QString& hostname);
     bool handleEntry(Entry* entry, const QString& url, const QString& submitUrl);
     bool handleURL(const QString& entryUrl, const QString& siteUrlStr, const QString& formUrlStr);
     QString getTopLevelDomainFromUrl(const QString& url) const;
@@ -176,6 +178,14 @@ private:
     QPointer<DatabaseWidget> m_currentDatabaseWidget;
     QScopedPointer<PasswordGeneratorWidget> m_passwordGenerator;
 
+    struct HostIndex
+    {
+        QPointer<Database> database;
+        int generation = 0;
+        QHash<QString, QList<Entry*>> entries;
+    };
+    QHash<const Database*, HostIndex> m_hostIndexes;
+
     Q_DISABLE_COPY(BrowserService);
 
     friend class TestBrowser;
@@ -67,15 +67,9 @@ int Analyze::executeWithDatabase(QSharedPointer<Database> database, QSharedPoint
             return EXIT_FAILURE;
         }
     } else {
-        QFile hibpFile(hibpDatabase);
-        if (!hibpFile.open(QFile::ReadOnly)) {
-            err << QObject::tr("Failed to open HIBP file %1: %2").arg(hibpDatabase).arg(hibpFile.errorString()) << endl;
-            return EXIT_FAILURE;
-        }
-
-        out << QObject::tr("Evaluating database entries against HIBP file, this will take a while…") << endl;
+        out << QObject::tr("Evaluating database entries against HIBP file…") << endl;
 
-        if (!HibpOffline::report(database, hibpFile, findings, &error)) {
+        if (!HibpOffline::report(database, hibpDatabase, findings, &error)) {
             err << error << endl;
             return EXIT_FAILURE;
         }
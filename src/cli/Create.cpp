@@ -18,6 +18,8 @@
 #include "Create.h"
 
 #include "Utils.h"
+#include "crypto/kdf/Argon2Kdf.h"
+#include "format/KeePass2.h"
 #include "keys/FileKey.h"
 
 #include <QCommandLineParser>
@@ -29,6 +31,17 @@ const QCommandLineOption Create::DecryptionTimeOption =
                        QObject::tr("Target decryption time in MS for the database."),
                        QObject::tr("time"));
 
+const QCommandLineOption Create::CalibrateOption =
+    QCommandLineOption(QStringList() << "calibrate",
+                       QObject::tr("Use Argon2 and choose its memory, iterations and parallelism for the "
+                                   "strongest settings that meet the target decryption time."));
+
+const QCommandLineOption Create::MaxMemoryOption =
+    QCommandLineOption(QStringList() << "max-memory",
+                       QObject::tr("Upper limit of the memory chosen by --calibrate in MiB (default: %1).")
+                           .arg(Argon2Kdf::DEFAULT_CALIBRATION_MEMORY / 1024),
+                       QObject::tr("MiB"));
+
 const QCommandLineOption Create::SetKeyFileOption =
     QCommandLineOption(QStringList() << "k"
                                      << "set-key-file",
@@ -48,6 +61,8 @@ Create::Create()
     options.append(Create::SetKeyFileOption);
     options.append(Create::SetPasswordOption);
     options.append(Create::DecryptionTimeOption);
+    options.append(Create::CalibrateOption);
+    options.append(Create::MaxMemoryOption);
 }
 
 QSharedPointer<Database> Create::initializeDatabaseFromOptions(const QSharedPointer<QCommandLineParser>& parser)
@@ -76,6 +91,28 @@ QSharedPointer<Database> Create::initializeDatabaseFromOptions(const QSharedPoin
         }
     }
 
+    bool calibrate = parser->isSet(Create::CalibrateOption);
+    if (calibrate && decryptionTime == 0) {
+        decryptionTime = Kdf::DEFAULT_ENCRYPTION_TIME;
+    }
+
+    quint64 maxMemory = Argon2Kdf::DEFAULT_CALIBRATION_MEMORY;
+    if (parser->isSet(Create::MaxMemoryOption)) {
+        bool ok = false;
+        QString maxMemoryValue = parser->value(Create::MaxMemoryOption);
+        // Range check in KiB, multiplying first could wrap around
+        const quint64 maxMemoryKib = maxMemoryValue.toULongLong(&ok);
+        if (!ok || maxMemoryKib == 0 || maxMemoryKib >= (1ULL << 32) / 1024) {
+            err << QObject::tr("Invalid maximum memory %1.").arg(maxMemoryValue) << endl;
+            return {};
+        }
+        maxMemory = maxMemoryKib * 1024;
+        if (!calibrate) {
+            err << QObject::tr("The maximum memory can only be set together with --calibrate.") << endl;
+            return {};
+        }
+    }
+
     auto key = QSharedPointer<CompositeKey>::create();
 
     if (parser->isSet(Create::SetPasswordOption)) {
@@ -108,7 +145,20 @@ QSharedPointer<Database> Create::initializeDatabaseFromOptions(const QSharedPoin
     auto db = QSharedPointer<Database>::create();
     db->setKey(key);
 
-    if (decryptionTime != 0) {
+    if (calibrate) {
+        auto kdf = KeePass2::uuidToKdf(KeePass2::KDF_ARGON2D).staticCast<Argon2Kdf>();
+
+        out << QObject::tr("Calibrating Argon2 for %1ms delay.").arg(decryptionTime) << endl;
+        if (!kdf->calibrate(decryptionTime, maxMemory) || !db->changeKdf(kdf)) {
+            err << QObject::tr("error while setting database key derivation settings.") << endl;
+            return {};
+        }
+        out << QObject::tr("Setting %1 rounds, %2 MiB and %3 threads for key derivation function.")
+                   .arg(QString::number(kdf->rounds()),
+                        QString::number(kdf->memory() / 1024),
+                        QString::number(kdf->parallelism()))
+            << endl;
+    } else if (decryptionTime != 0) {
         auto kdf = db->kdf();
         Q_ASSERT(kdf);
 
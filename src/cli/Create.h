@@ -31,6 +31,8 @@ public:
     static const QCommandLineOption SetKeyFileOption;
     static const QCommandLineOption SetPasswordOption;
     static const QCommandLineOption DecryptionTimeOption;
+    static const QCommandLineOption CalibrateOption;
+    static const QCommandLineOption MaxMemoryOption;
 };
 
 #endif // KEEPASSXC_CREATE_H
@@ -17,8 +17,10 @@
 
 #include "Diceware.h"
 
+#include "Generate.h"
 #include "Utils.h"
 #include "core/PassphraseGenerator.h"
+#include "crypto/Random.h"
 
 #include <QCommandLineParser>
 
@@ -40,6 +42,8 @@ Diceware::Diceware()
     description = QObject::tr("Generate a new random diceware passphrase.");
     options.append(Diceware::WordCountOption);
     options.append(Diceware::WordListOption);
+    options.append(Generate::CountOption);
+    options.append(Generate::ThreadsOption);
 }
 
 int Diceware::execute(const QStringList& arguments)
@@ -76,6 +80,18 @@ int Diceware::execute(const QStringList& arguments)
         return EXIT_FAILURE;
     }
 
+    int count, threads;
+    if (!Generate::parseBulkOptions(parser, count, threads)) {
+        return EXIT_FAILURE;
+    }
+
+    if (count > 1) {
+        Utils::writeGenerated(count, threads, [&dicewareGenerator](int size, RandomBuffer& random) {
+            return dicewareGenerator.generatePassphrases(size, random);
+        });
+        return EXIT_SUCCESS;
+    }
+
     QString password = dicewareGenerator.generatePassphrase();
     out << password << endl;
 
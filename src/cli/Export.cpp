@@ -52,7 +52,10 @@ int Export::executeWithDatabase(QSharedPointer<Database> database, QSharedPointe
         out.write(xmlData.constData());
     } else if (format.startsWith(QStringLiteral("csv"), Qt::CaseInsensitive)) {
         CsvExporter csvExporter;
-        out << csvExporter.exportDatabase(database);
+        if (!csvExporter.exportDatabase(out, database)) {
+            err << QObject::tr("Unable to export database to CSV: %1").arg(csvExporter.errorString()) << endl;
+            return EXIT_FAILURE;
+        }
     } else {
         err << QObject::tr("Unsupported format %1").arg(format) << endl;
         return EXIT_FAILURE;
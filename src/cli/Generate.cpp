@@ -19,6 +19,7 @@
 
 #include "Utils.h"
 #include "core/PasswordGenerator.h"
+#include "crypto/Random.h"
 
 #include <QCommandLineParser>
 
@@ -64,6 +65,18 @@ const QCommandLineOption Generate::ExcludeSimilarCharsOption =
 
 const QCommandLineOption Generate::IncludeEveryGroupOption =
     QCommandLineOption(QStringList() << "every-group", QObject::tr("Include characters from every selected group"));
+
+const QCommandLineOption Generate::CountOption =
+    QCommandLineOption(QStringList() << "count",
+                       QObject::tr("Number of values to generate, one per line."),
+                       QObject::tr("count", "CLI parameter"));
+
+const QCommandLineOption Generate::ThreadsOption =
+    QCommandLineOption(QStringList() << "threads",
+                       QObject::tr("Number of threads used to generate the values. [Default: %1]")
+                           .arg(Generate::DefaultThreadCount),
+                       QObject::tr("threads", "CLI parameter"));
+
 Generate::Generate()
 {
     name = QString("generate");
@@ -78,6 +91,8 @@ Generate::Generate()
     options.append(Generate::ExcludeSimilarCharsOption);
     options.append(Generate::IncludeEveryGroupOption);
     options.append(Generate::CustomCharacterSetOption);
+    options.append(Generate::CountOption);
+    options.append(Generate::ThreadsOption);
 }
 
 /**
@@ -145,6 +160,37 @@ QSharedPointer<PasswordGenerator> Generate::createGenerator(QSharedPointer<QComm
     return passwordGenerator;
 }
 
+/**
+ * Reads the bulk generation options of the parser object.
+ */
+bool Generate::parseBulkOptions(QSharedPointer<QCommandLineParser> parser, int& count, int& threads)
+{
+    auto& err = Utils::STDERR;
+    bool ok = true;
+
+    count = 1;
+    QString countValue = parser->value(Generate::CountOption);
+    if (!countValue.isEmpty()) {
+        count = countValue.toInt(&ok);
+        if (!ok || count <= 0) {
+            err << QObject::tr("Invalid count %1").arg(countValue) << endl;
+            return false;
+        }
+    }
+
+    threads = Generate::DefaultThreadCount;
+    QString threadsValue = parser->value(Generate::ThreadsOption);
+    if (!threadsValue.isEmpty()) {
+        threads = threadsValue.toInt(&ok);
+        if (!ok || threads <= 0) {
+            err << QObject::tr("Invalid thread count %1").arg(threadsValue) << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 int Generate::execute(const QStringList& arguments)
 {
     QSharedPointer<QCommandLineParser> parser = getCommandLineParser(arguments);
@@ -157,6 +203,18 @@ int Generate::execute(const QStringList& arguments)
         return EXIT_FAILURE;
     }
 
+    int count, threads;
+    if (!Generate::parseBulkOptions(parser, count, threads)) {
+        return EXIT_FAILURE;
+    }
+
+    if (count > 1) {
+        Utils::writeGenerated(count, threads, [&passwordGenerator](int size, RandomBuffer& random) {
+            return passwordGenerator->generatePasswords(size, random);
+        });
+        return EXIT_SUCCESS;
+    }
+
     auto& out = Utils::STDOUT;
     QString password = passwordGenerator->generatePassword();
     out << password << endl;
@@ -29,6 +29,7 @@ public:
     int execute(const QStringList& arguments) override;
 
     static QSharedPointer<PasswordGenerator> createGenerator(QSharedPointer<QCommandLineParser> parser);
+    static bool parseBulkOptions(QSharedPointer<QCommandLineParser> parser, int& count, int& threads);
 
     static const QCommandLineOption PasswordLengthOption;
     static const QCommandLineOption LowerCaseOption;
@@ -40,6 +41,10 @@ public:
     static const QCommandLineOption ExcludeSimilarCharsOption;
     static const QCommandLineOption IncludeEveryGroupOption;
     static const QCommandLineOption CustomCharacterSetOption;
+    static const QCommandLineOption CountOption;
+    static const QCommandLineOption ThreadsOption;
+
+    static constexpr int DefaultThreadCount = 1;
 };
 
 #endif // KEEPASSXC_GENERATE_H
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HibpIndex.h"
+
+#include "Utils.h"
+#include "core/HibpOffline.h"
+
+#include <QCommandLineParser>
+#include <QFile>
+
+HibpIndex::HibpIndex()
+{
+    name = QString("hibp-index");
+    description = QObject::tr("Build a binary index from a HIBP file for fast offline lookups.");
+    positionalArguments.append(
+        {QString("hibp"), QObject::tr("Path of the HIBP file, ordered by hash."), QString("")});
+    positionalArguments.append({QString("index"), QObject::tr("Path of the index file to create."), QString("")});
+}
+
+int HibpIndex::execute(const QStringList& arguments)
+{
+    QSharedPointer<QCommandLineParser> parser = getCommandLineParser(arguments);
+    if (parser.isNull()) {
+        return EXIT_FAILURE;
+    }
+
+    auto& out = Utils::STDOUT;
+    auto& err = Utils::STDERR;
+
+    const QStringList args = parser->positionalArguments();
+    const QString& hibpPath = args.at(0);
+    const QString& indexPath = args.at(1);
+
+    QFile hibpFile(hibpPath);
+    if (!hibpFile.open(QFile::ReadOnly)) {
+        err << QObject::tr("Failed to open HIBP file %1: %2").arg(hibpPath, hibpFile.errorString()) << endl;
+        return EXIT_FAILURE;
+    }
+
+    QFile indexFile(indexPath);
+    if (!indexFile.open(QFile::ReadWrite | QFile::Truncate)) {
+        err << QObject::tr("Failed to open index file %1: %2").arg(indexPath, indexFile.errorString()) << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!parser->isSet(Command::QuietOption)) {
+        out << QObject::tr("Building HIBP index, this will take a while…") << endl;
+    }
+
+    QString error;
+    if (!HibpOffline::buildIndex(hibpFile, indexFile, &error)) {
+        indexFile.remove();
+        err << error << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!parser->isSet(Command::QuietOption)) {
+        out << QObject::tr("Successfully created HIBP index %1.").arg(indexPath) << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -43,6 +43,8 @@ Import::Import()
     options.append(Create::SetKeyFileOption);
     options.append(Create::SetPasswordOption);
     options.append(Create::DecryptionTimeOption);
+    options.append(Create::CalibrateOption);
+    options.append(Create::MaxMemoryOption);
 }
 
 int Import::execute(const QStringList& arguments)
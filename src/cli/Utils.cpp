@@ -19,6 +19,7 @@
 
 #include "core/Database.h"
 #include "core/EntryAttributes.h"
+#include "crypto/Random.h"
 #include "keys/FileKey.h"
 #ifdef WITH_XC_YUBIKEY
 #include "keys/ChallengeResponseKey.h"
@@ -33,6 +34,7 @@
 
 #include <QFileInfo>
 #include <QProcess>
+#include <QtConcurrent>
 
 namespace Utils
 {
@@ -418,4 +420,50 @@ namespace Utils
 
         return true;
     }
+
+    void writeGenerated(int count, int threads, const std::function<QStringList(int, RandomBuffer&)>& generate)
+    {
+        // Small enough to stream the output, large enough to amortize the thread handoff
+        const int chunkSize = 4096;
+        const int bufferSize = 64 * 1024;
+
+        auto& out = Utils::STDOUT;
+        auto writeChunk = [&out](const QStringList& values) {
+            for (const QString& value : values) {
+                out << value << '\n';
+            }
+            out.flush();
+        };
+
+        threads = qMax(1, threads);
+        if (threads == 1) {
+            RandomBuffer random(bufferSize);
+            for (int remaining = count; remaining > 0; remaining -= chunkSize) {
+                writeChunk(generate(qMin(chunkSize, remaining), random));
+            }
+            return;
+        }
+
+        // Make sure the shared generator exists before the workers use it
+        randomGen();
+
+        QVector<QSharedPointer<RandomBuffer>> buffers;
+        for (int i = 0; i < threads; ++i) {
+            buffers.append(QSharedPointer<RandomBuffer>::create(bufferSize));
+        }
+
+        int remaining = count;
+        while (remaining > 0) {
+            QList<QFuture<QStringList>> chunks;
+            for (int i = 0; i < threads && remaining > 0; ++i) {
+                const int size = qMin(chunkSize, remaining);
+                remaining -= size;
+                RandomBuffer* random = buffers[i].data();
+                chunks.append(QtConcurrent::run([&generate, size, random] { return generate(size, *random); }));
+            }
+            for (auto& chunk : chunks) {
+                writeChunk(chunk.result());
+            }
+        }
+    }
 } // namespace Utils
@@ -20,11 +20,14 @@
 
 #include <QTextStream>
 
+#include <functional>
+
 class CompositeKey;
 class Database;
 class EntryAttributes;
 class FileKey;
 class PasswordKey;
+class RandomBuffer;
 
 namespace Utils
 {
@@ -55,6 +58,13 @@ namespace Utils
      * (case-insensitive).
      */
     QStringList findAttributes(const EntryAttributes& attributes, const QString& name);
+
+    /**
+     * Writes `count` values to STDOUT, one per line. The values are produced
+     * in chunks by `generate`, which is called on up to `threads` threads at
+     * once and has to be thread safe.
+     */
+    void writeGenerated(int count, int threads, const std::function<QStringList(int, RandomBuffer&)>& generate);
 }; // namespace Utils
 
 #endif // KEEPASSXC_UTILS_H
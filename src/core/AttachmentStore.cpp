@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AttachmentStore.h"
+
+#include "crypto/CryptoHash.h"
+
+AttachmentBlob::AttachmentBlob(const QByteArray& data, const QByteArray& hash)
+    : m_data(data)
+    , m_hash(hash)
+{
+}
+
+const QByteArray& AttachmentBlob::data() const
+{
+    return m_data;
+}
+
+const QByteArray& AttachmentBlob::hash() const
+{
+    return m_hash;
+}
+
+AttachmentStore* AttachmentStore::instance()
+{
+    static AttachmentStore store;
+    return &store;
+}
+
+/**
+ * Returns the blob holding @p data, creating it if the data is not stored yet.
+ */
+AttachmentBlobPtr AttachmentStore::store(const QByteArray& data)
+{
+    // References are only dropped outside of the lock, the last one releases the blob
+    AttachmentBlobPtr blob;
+    {
+        QMutexLocker locker(&m_mutex);
+        blob = m_sharedData.value(data.constData()).toStrongRef();
+    }
+    if (blob && blob->data().size() == data.size()) {
+        return blob;
+    }
+    blob.reset();
+
+    // Hash outside of the lock, attachments can be several megabytes
+    const QByteArray hash = CryptoHash::hash(data, CryptoHash::Sha256);
+
+    QMutexLocker locker(&m_mutex);
+    blob = m_blobs.value(hash).toStrongRef();
+    if (!blob) {
+        blob = AttachmentBlobPtr(new AttachmentBlob(data, hash), [](const AttachmentBlob* blob) {
+            AttachmentStore::instance()->release(blob);
+            delete blob;
+        });
+        m_blobs.insert(hash, blob);
+        m_sharedData.insert(blob->data().constData(), blob);
+    }
+    return blob;
+}
+
+/**
+ * Number of blobs currently stored.
+ */
+int AttachmentStore::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_blobs.size();
+}
+
+void AttachmentStore::release(const AttachmentBlob* blob)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // The entries may already point to a new blob with the same contents
+    auto it = m_blobs.find(blob->hash());
+    if (it != m_blobs.end() && it->isNull()) {
+        m_blobs.erase(it);
+    }
+    auto sharedIt = m_sharedData.find(blob->data().constData());
+    if (sharedIt != m_sharedData.end() && sharedIt->isNull()) {
+        m_sharedData.erase(sharedIt);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ATTACHMENTSTORE_H
+#define KEEPASSXC_ATTACHMENTSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+
+/**
+ * Immutable attachment contents, identified by the SHA-256 hash of the data.
+ */
+class AttachmentBlob
+{
+public:
+    const QByteArray& data() const;
+    const QByteArray& hash() const;
+
+private:
+    friend class AttachmentStore;
+    AttachmentBlob(const QByteArray& data, const QByteArray& hash);
+
+    const QByteArray m_data;
+    const QByteArray m_hash;
+};
+
+typedef QSharedPointer<const AttachmentBlob> AttachmentBlobPtr;
+
+/**
+ * Content addressed store of attachment data. Identical attachments of all
+ * entries, history items and databases share one blob, so their data is kept
+ * in memory once and hashed once. Blobs are released with their last user.
+ */
+class AttachmentStore
+{
+public:
+    static AttachmentStore* instance();
+
+    AttachmentBlobPtr store(const QByteArray& data);
+    int size() const;
+
+private:
+    AttachmentStore() = default;
+    Q_DISABLE_COPY(AttachmentStore)
+
+    void release(const AttachmentBlob* blob);
+
+    mutable QMutex m_mutex;
+    QHash<QByteArray, QWeakPointer<const AttachmentBlob>> m_blobs;
+    // Data pointers of the stored blobs, data sharing them needs no hashing
+    QHash<const char*, QWeakPointer<const AttachmentBlob>> m_sharedData;
+};
+
+#endif // KEEPASSXC_ATTACHMENTSTORE_H
@@ -122,6 +122,8 @@ public:
         Security_NoConfirmMoveEntryToRecycleBin,
         Security_EnableCopyOnDoubleClick,
         Security_QuickUnlock,
+        Security_DerivedKeyCache,
+        Security_DerivedKeyCacheTimeout,
 
         Browser_Enabled,
         Browser_ShowNotification,
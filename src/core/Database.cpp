@@ -19,6 +19,8 @@
 #include "Database.h"
 
 #include "core/AsyncTask.h"
+#include "core/EntryReferenceIndex.h"
+#include "core/EntrySearchIndex.h"
 #include "core/FileWatcher.h"
 #include "core/Group.h"
 #include "format/KdbxXmlReader.h"
@@ -36,6 +38,8 @@ QHash<QUuid, QPointer<Database>> Database::s_uuidMap;
 
 Database::Database()
     : m_metadata(new Metadata(this))
+    , m_searchIndex(new EntrySearchIndex(this))
+    , m_entryReferenceIndex(new EntryReferenceIndex(this))
     , m_data()
     , m_rootGroup(nullptr)
     , m_fileWatcher(new FileWatcher(this))
@@ -59,6 +63,14 @@ Database::Database()
     connect(this, &Database::modified, this, [this] { updateTagList(); });
     connect(this, &Database::databaseSaved, this, [this]() { updateCommonUsernames(); });
     connect(m_fileWatcher, &FileWatcher::fileChanged, this, &Database::databaseFileChanged);
+    // changes made while modified signals are blocked are not seen by the placeholder caches
+    connect(this, &Database::emitModifiedChanged, this, &Database::invalidatePlaceholderCaches);
+    connect(this, &Database::emitModifiedChanged, this, [this](bool value) {
+        if (value && modifiedWhileBlocked()) {
+            m_searchIndex->reset();
+            m_entryReferenceIndex->reset();
+        }
+    });
 
     // static uuid map
     s_uuidMap.insert(m_uuid, this);
@@ -573,6 +585,244 @@ void Database::setRootGroup(Group* group)
 
     m_rootGroup = group;
     m_rootGroup->setParent(this);
+
+    m_entryUuidIndex.clear();
+    m_groupUuidIndex.clear();
+    addGroupToIndex(m_rootGroup);
+    invalidatePlaceholderCaches();
+    if (m_searchIndex) {
+        m_searchIndex->reset();
+    }
+    if (m_entryReferenceIndex) {
+        m_entryReferenceIndex->reset();
+    }
+}
+
+/**
+ * Returns all entries of this database with the given UUID, which
+ * is at most one entry unless the database contains duplicates.
+ * History items are not included.
+ */
+QList<Entry*> Database::entriesByUuid(const QUuid& uuid) const
+{
+    return m_entryUuidIndex.values(uuid);
+}
+
+/**
+ * Returns all groups of this database with the given UUID.
+ */
+QList<Group*> Database::groupsByUuid(const QUuid& uuid) const
+{
+    return m_groupUuidIndex.values(uuid);
+}
+
+void Database::updateUuidIndex(Entry* entry, const QUuid& oldUuid)
+{
+    if (m_entryUuidIndex.remove(oldUuid, entry) > 0) {
+        m_entryUuidIndex.insert(entry->uuid(), entry);
+    }
+}
+
+void Database::updateUuidIndex(Group* group, const QUuid& oldUuid)
+{
+    if (m_groupUuidIndex.remove(oldUuid, group) > 0) {
+        m_groupUuidIndex.insert(group->uuid(), group);
+    }
+}
+
+/**
+ * Returns the first entry in tree order whose field of the given type
+ * equals the term, as used for resolving {REF:} placeholders. Custom
+ * attributes match any attribute value of the entry.
+ */
+Entry* Database::entryByReference(const QString& term, EntryReferenceType referenceType)
+{
+    if (referenceType == EntryReferenceType::QUuid) {
+        return m_rootGroup->findEntryByUuid(QUuid::fromRfc4122(QByteArray::fromHex(term.toLatin1())));
+    } else if (referenceType == EntryReferenceType::Unknown) {
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_referenceIndexMutex);
+
+    auto index = m_referenceIndex.find(static_cast<int>(referenceType));
+    if (index == m_referenceIndex.end()) {
+        QHash<QString, Entry*> values;
+        for (const Group* group : m_rootGroup->groupsRecursive(true)) {
+            for (Entry* entry : group->entries()) {
+                if (referenceType == EntryReferenceType::CustomAttributes) {
+                    for (const QString& value : entry->attributes()->values(entry->attributes()->keys())) {
+                        if (!values.contains(value)) {
+                            values.insert(value, entry);
+                        }
+                    }
+                    continue;
+                }
+
+                const QString value = entry->referenceFieldValue(referenceType);
+                if (!values.contains(value)) {
+                    values.insert(value, entry);
+                }
+            }
+        }
+        index = m_referenceIndex.insert(static_cast<int>(referenceType), values);
+    }
+
+    return index->value(term);
+}
+
+/**
+ * Returns the first entry in tree order at the given path, see
+ * Group::findEntryByPath(). A path without a leading slash matches the
+ * entry title at any depth.
+ *
+ * @param entryPath path relative to the root group, normalized to start
+ *                  with a slash unless it is a bare title
+ */
+Entry* Database::entryByPath(const QString& entryPath)
+{
+    QMutexLocker locker(&m_referenceIndexMutex);
+
+    if (!m_pathIndex.built) {
+        buildPathIndex(m_rootGroup, "/");
+        m_pathIndex.built = true;
+    }
+
+    if (entryPath.startsWith("/")) {
+        return m_pathIndex.entries.value(entryPath);
+    }
+    return m_pathIndex.titles.value(entryPath);
+}
+
+/**
+ * Returns the first group in tree order at the given path, see
+ * Group::findGroupByPath().
+ *
+ * @param groupPath path relative to the root group, normalized to start
+ *                  and end with a slash
+ */
+Group* Database::groupByPath(const QString& groupPath)
+{
+    QMutexLocker locker(&m_referenceIndexMutex);
+
+    if (!m_pathIndex.built) {
+        buildPathIndex(m_rootGroup, "/");
+        m_pathIndex.built = true;
+    }
+
+    return m_pathIndex.groups.value(groupPath);
+}
+
+/**
+ * Adds the group, its entries and its children to the path index in the
+ * order Group::findEntryByPathRecursive() visits them, so the first
+ * entry or group on a path wins. Group names and entry titles may
+ * contain slashes, therefore whole paths are keyed instead of segments.
+ */
+void Database::buildPathIndex(Group* group, const QString& basePath)
+{
+    if (!m_pathIndex.groups.contains(basePath)) {
+        m_pathIndex.groups.insert(basePath, group);
+    }
+
+    for (Entry* entry : group->entries()) {
+        const QString entryPath = basePath + entry->title();
+        if (!m_pathIndex.entries.contains(entryPath)) {
+            m_pathIndex.entries.insert(entryPath, entry);
+        }
+        if (!m_pathIndex.titles.contains(entry->title())) {
+            m_pathIndex.titles.insert(entry->title(), entry);
+        }
+    }
+
+    for (Group* child : group->children()) {
+        buildPathIndex(child, basePath + child->name() + "/");
+    }
+}
+
+/**
+ * Returns a counter that changes whenever the result of resolving
+ * placeholders of any entry in this database may have changed.
+ */
+int Database::placeholderGeneration() const
+{
+    return m_placeholderGeneration.loadAcquire();
+}
+
+/**
+ * Returns the index used by EntrySearcher to narrow down searches.
+ */
+EntrySearchIndex* Database::searchIndex() const
+{
+    return m_searchIndex;
+}
+
+/**
+ * Returns the index of which entries reference which other entries.
+ */
+EntryReferenceIndex* Database::entryReferenceIndex() const
+{
+    return m_entryReferenceIndex;
+}
+
+void Database::invalidatePlaceholderCaches()
+{
+    QMutexLocker locker(&m_referenceIndexMutex);
+    m_referenceIndex.clear();
+    m_pathIndex = PathIndex();
+    m_placeholderGeneration.ref();
+}
+
+void Database::addEntryToIndex(Entry* entry)
+{
+    invalidatePlaceholderCaches();
+    if (!m_entryUuidIndex.contains(entry->uuid(), entry)) {
+        m_entryUuidIndex.insert(entry->uuid(), entry);
+    }
+    if (m_searchIndex) {
+        m_searchIndex->addEntry(entry);
+    }
+    if (m_entryReferenceIndex) {
+        m_entryReferenceIndex->addEntry(entry);
+    }
+}
+
+void Database::removeEntryFromIndex(Entry* entry)
+{
+    invalidatePlaceholderCaches();
+    m_entryUuidIndex.remove(entry->uuid(), entry);
+    if (m_searchIndex) {
+        m_searchIndex->removeEntry(entry);
+    }
+    if (m_entryReferenceIndex) {
+        m_entryReferenceIndex->removeEntry(entry);
+    }
+}
+
+void Database::addGroupToIndex(Group* group)
+{
+    invalidatePlaceholderCaches();
+    if (!m_groupUuidIndex.contains(group->uuid(), group)) {
+        m_groupUuidIndex.insert(group->uuid(), group);
+    }
+    for (Entry* entry : group->entries()) {
+        addEntryToIndex(entry);
+    }
+    for (Group* child : group->children()) {
+        addGroupToIndex(child);
+    }
+}
+
+void Database::removeGroupFromIndex(Group* group)
+{
+    invalidatePlaceholderCaches();
+    m_groupUuidIndex.remove(group->uuid(), group);
+    for (Entry* entry : group->entries()) {
+        removeEntryFromIndex(entry);
+    }
+    for (Group* child : group->children()) {
+        removeGroupFromIndex(child);
+    }
 }
 
 Metadata* Database::metadata()
@@ -907,6 +1157,7 @@ bool Database::hasNonDataChanges() const
 void Database::markAsModified()
 {
     m_modified = true;
+    invalidatePlaceholderCaches();
     if (modifiedSignalEnabled() && !m_modifiedTimer.isActive()) {
         // Small time delay prevents numerous consecutive saves due to repeated signals
         startModifiedTimer();
@@ -19,6 +19,7 @@
 #ifndef KEEPASSX_DATABASE_H
 #define KEEPASSX_DATABASE_H
 
+#include <QAtomicInt>
 #include <QDateTime>
 #include <QHash>
 #include <QMutex>
@@ -34,6 +35,8 @@
 
 class Entry;
 enum class EntryReferenceType;
+class EntryReferenceIndex;
+class EntrySearchIndex;
 class FileWatcher;
 class Group;
 class Metadata;
@@ -148,6 +151,17 @@ public:
     bool changeKdf(const QSharedPointer<Kdf>& kdf);
     QByteArray transformedDatabaseKey() const;
 
+    QList<Entry*> entriesByUuid(const QUuid& uuid) const;
+    QList<Group*> groupsByUuid(const QUuid& uuid) const;
+    void updateUuidIndex(Entry* entry, const QUuid& oldUuid);
+    void updateUuidIndex(Group* group, const QUuid& oldUuid);
+    Entry* entryByReference(const QString& term, EntryReferenceType referenceType);
+    Entry* entryByPath(const QString& entryPath);
+    Group* groupByPath(const QString& groupPath);
+    int placeholderGeneration() const;
+    EntrySearchIndex* searchIndex() const;
+    EntryReferenceIndex* entryReferenceIndex() const;
+
     static Database* databaseByUuid(const QUuid& uuid);
 
 public slots:
@@ -156,6 +170,10 @@ public slots:
     void updateCommonUsernames(int topN = 10);
     void updateTagList();
     void markNonDataChange();
+    void addEntryToIndex(Entry* entry);
+    void removeEntryFromIndex(Entry* entry);
+    void addGroupToIndex(Group* group);
+    void removeGroupFromIndex(Group* group);
 
 signals:
     void filePathChanged(const QString& oldPath, const QString& newPath);
@@ -217,7 +235,12 @@ private:
     void startModifiedTimer();
     void stopModifiedTimer();
 
+    void invalidatePlaceholderCaches();
+    void buildPathIndex(Group* group, const QString& basePath);
+
     QPointer<Metadata> const m_metadata;
+    QPointer<EntrySearchIndex> const m_searchIndex;
+    QPointer<EntryReferenceIndex> const m_entryReferenceIndex;
     DatabaseData m_data;
     QPointer<Group> m_rootGroup;
     QList<DeletedObject> m_deletedObjects;
@@ -231,6 +254,26 @@ private:
     QStringList m_commonUsernames;
     QStringList m_tagList;
 
+    // Entries and groups in the tree of m_rootGroup, maintained from the group signals
+    QMultiHash<QUuid, Entry*> m_entryUuidIndex;
+    QMultiHash<QUuid, Group*> m_groupUuidIndex;
+
+    // Field value to first matching entry, built lazily per reference type and
+    // dropped on any modification of the database
+    QHash<int, QHash<QString, Entry*>> m_referenceIndex;
+    QMutex m_referenceIndexMutex;
+
+    // Normalized paths and titles to the first matching entry or group in tree
+    // order, built lazily and dropped together with m_referenceIndex
+    struct PathIndex
+    {
+        bool built = false;
+        QHash<QString, Group*> groups;
+        QHash<QString, Entry*> entries;
+        QHash<QString, Entry*> titles;
+    } m_pathIndex;
+    QAtomicInt m_placeholderGeneration;
+
     QUuid m_uuid;
     static QHash<QUuid, QPointer<Database>> s_uuidMap;
 };
@@ -35,6 +35,21 @@ const int Entry::ResolveMaximumDepth = 10;
 const QString Entry::AutoTypeSequenceUsername = "{USERNAME}{ENTER}";
 const QString Entry::AutoTypeSequencePassword = "{PASSWORD}{ENTER}";
 
+namespace
+{
+    enum ResolvedFieldIndex
+    {
+        ResolvedTitle,
+        ResolvedUsername,
+        ResolvedPassword,
+        ResolvedUrl
+    };
+
+    // Counts placeholders whose value changes over time ({TOTP}, {DT_*}, {DB_DIR})
+    // so resolved values depending on them are never cached
+    thread_local int volatilePlaceholderCount = 0;
+} // namespace
+
 Entry::Entry()
     : m_attributes(new EntryAttributes(this))
     , m_attachments(new EntryAttachments(this))
@@ -608,7 +623,10 @@ QString Entry::path() const
 void Entry::setUuid(const QUuid& uuid)
 {
     Q_ASSERT(!uuid.isNull());
-    set(m_uuid, uuid);
+    const QUuid oldUuid = m_uuid;
+    if (set(m_uuid, uuid) && database()) {
+        database()->updateUuidIndex(this, oldUuid);
+    }
 }
 
 void Entry::setIcon(int iconNumber)
@@ -801,7 +819,6 @@ void Entry::truncateHistory()
     int histMaxSize = db->metadata()->historyMaxSize();
     if (histMaxSize > -1) {
         int size = 0;
-        QSet<QByteArray> foundAttachments = attachments()->values();
 
         QMutableListIterator<Entry*> i(m_history);
         i.toBack();
@@ -811,7 +828,6 @@ void Entry::truncateHistory()
             // don't calculate size if it's already above the maximum
             if (size <= histMaxSize) {
                 size += historyItem->size();
-                foundAttachments += historyItem->attachments()->values();
             }
 
             if (size > histMaxSize) {
@@ -1025,6 +1041,7 @@ QString Entry::resolvePlaceholderRecursive(const QString& placeholder, int maxDe
         }
         return resolveMultiplePlaceholdersRecursive(url(), maxDepth - 1);
     case PlaceholderType::DbDir: {
+        ++volatilePlaceholderCount;
         QFileInfo fileInfo(database()->filePath());
         return fileInfo.absoluteDir().absolutePath();
     }
@@ -1043,6 +1060,7 @@ QString Entry::resolvePlaceholderRecursive(const QString& placeholder, int maxDe
     }
     case PlaceholderType::Totp:
         // totp can't have placeholder inside
+        ++volatilePlaceholderCount;
         return totp();
     case PlaceholderType::CustomAttribute: {
         const QString key = placeholder.mid(3, placeholder.length() - 4); // {S:attr} => mid(3, len - 4)
@@ -1064,6 +1082,7 @@ QString Entry::resolvePlaceholderRecursive(const QString& placeholder, int maxDe
     case PlaceholderType::DateTimeUtcHour:
     case PlaceholderType::DateTimeUtcMinute:
     case PlaceholderType::DateTimeUtcSecond:
+        ++volatilePlaceholderCount;
         return resolveMultiplePlaceholdersRecursive(resolveDateTimePlaceholder(typeOfPlaceholder), maxDepth - 1);
     }
 
@@ -1296,6 +1315,61 @@ QString Entry::resolvePlaceholder(const QString& placeholder) const
     return resolvePlaceholderRecursive(placeholder, ResolveMaximumDepth);
 }
 
+/**
+ * Returns the title with all placeholders resolved. The result is cached
+ * until the database is modified.
+ */
+QString Entry::resolvedTitle() const
+{
+    return resolveCachedField(ResolvedTitle, title());
+}
+
+QString Entry::resolvedUsername() const
+{
+    return resolveCachedField(ResolvedUsername, username());
+}
+
+QString Entry::resolvedPassword() const
+{
+    return resolveCachedField(ResolvedPassword, password());
+}
+
+QString Entry::resolvedUrl() const
+{
+    return resolveCachedField(ResolvedUrl, url());
+}
+
+QString Entry::resolveCachedField(int field, const QString& value) const
+{
+    // Values without placeholders resolve to themselves
+    if (!value.contains('{')) {
+        return value;
+    }
+
+    const Database* db = database();
+    if (!db) {
+        return resolveMultiplePlaceholders(value);
+    }
+
+    const int generation = db->placeholderGeneration();
+    {
+        QMutexLocker locker(&m_resolvedFieldsMutex);
+        const ResolvedField& cached = m_resolvedFields[field];
+        if (cached.database == db && cached.generation == generation) {
+            return cached.value;
+        }
+    }
+
+    // Resolve without holding the lock, references may resolve fields of other entries
+    const int volatileCount = volatilePlaceholderCount;
+    const QString resolved = resolveMultiplePlaceholders(value);
+    if (volatilePlaceholderCount == volatileCount) {
+        QMutexLocker locker(&m_resolvedFieldsMutex);
+        m_resolvedFields[field] = {db, generation, resolved};
+    }
+    return resolved;
+}
+
 QString Entry::resolveUrlPlaceholder(const QString& str, Entry::PlaceholderType placeholderType) const
 {
     if (str.isEmpty()) {
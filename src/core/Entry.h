@@ -20,6 +20,7 @@
 #define KEEPASSX_ENTRY_H
 
 #include <QMap>
+#include <QMutex>
 #include <QPointer>
 #include <QUuid>
 
@@ -236,10 +237,15 @@ public:
     Entry* resolveReference(const QString& str) const;
     QString resolveMultiplePlaceholders(const QString& str) const;
     QString resolvePlaceholder(const QString& str) const;
+    QString resolvedTitle() const;
+    QString resolvedUsername() const;
+    QString resolvedPassword() const;
+    QString resolvedUrl() const;
     QString resolveUrlPlaceholder(const QString& str, PlaceholderType placeholderType) const;
     QString resolveDateTimePlaceholder(PlaceholderType placeholderType) const;
     PlaceholderType placeholderType(const QString& placeholder) const;
     QString resolveUrl(const QString& url) const;
+    QString referenceFieldValue(EntryReferenceType referenceType) const;
 
     /**
      * Call before and after set*() methods to create a history item
@@ -276,8 +282,7 @@ private:
     QString resolveMultiplePlaceholdersRecursive(const QString& str, int maxDepth) const;
     QString resolvePlaceholderRecursive(const QString& placeholder, int maxDepth) const;
     QString resolveReferencePlaceholderRecursive(const QString& placeholder, int maxDepth) const;
-    QString referenceFieldValue(EntryReferenceType referenceType) const;
-
+    QString resolveCachedField(int field, const QString& value) const;
     static QString buildReference(const QUuid& uuid, const QString& field);
     static EntryReferenceType referenceType(const QString& referenceStr);
 
@@ -295,6 +300,15 @@ private:
     bool m_modifiedSinceBegin;
     QPointer<Group> m_group;
     bool m_updateTimeinfo;
+
+    struct ResolvedField
+    {
+        const Database* database = nullptr;
+        int generation = 0;
+        QString value;
+    };
+    mutable ResolvedField m_resolvedFields[4];
+    mutable QMutex m_resolvedFieldsMutex;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Entry::CloneFlags)
@@ -50,12 +50,26 @@ bool EntryAttachments::hasKey(const QString& key) const
 
 QSet<QByteArray> EntryAttachments::values() const
 {
-    return asConst(m_attachments).values().toSet();
+    QSet<QByteArray> values;
+    for (const auto& blob : m_attachments) {
+        values.insert(blob->data());
+    }
+    return values;
 }
 
 QByteArray EntryAttachments::value(const QString& key) const
 {
-    return m_attachments.value(key);
+    const auto blob = m_attachments.value(key);
+    return blob ? blob->data() : QByteArray();
+}
+
+/**
+ * SHA-256 hash of the attachment data, computed once per distinct attachment.
+ */
+QByteArray EntryAttachments::hash(const QString& key) const
+{
+    const auto blob = m_attachments.value(key);
+    return blob ? blob->hash() : QByteArray();
 }
 
 void EntryAttachments::set(const QString& key, const QByteArray& value)
@@ -67,8 +81,8 @@ void EntryAttachments::set(const QString& key, const QByteArray& value)
         emit aboutToBeAdded(key);
     }
 
-    if (addAttachment || m_attachments.value(key) != value) {
-        m_attachments.insert(key, value);
+    if (addAttachment || m_attachments.value(key)->data() != value) {
+        m_attachments.insert(key, AttachmentStore::instance()->store(value));
         shouldEmitModified = true;
     }
 
@@ -126,6 +140,7 @@ void EntryAttachments::remove(const QStringList& keys)
 
 void EntryAttachments::rename(const QString& key, const QString& newKey)
 {
+    // The data stays shared with the stored blob, so it is not hashed again
     const QByteArray val = value(key);
     remove(key);
     set(newKey, val);
@@ -208,7 +223,7 @@ int EntryAttachments::attachmentsSize() const
 {
     int size = 0;
     for (auto it = m_attachments.constBegin(); it != m_attachments.constEnd(); ++it) {
-        size += it.key().toUtf8().size() + it.value().size();
+        size += it.key().toUtf8().size() + it.value()->data().size();
     }
     return size;
 }
@@ -18,6 +18,7 @@
 #ifndef KEEPASSX_ENTRYATTACHMENTS_H
 #define KEEPASSX_ENTRYATTACHMENTS_H
 
+#include "core/AttachmentStore.h"
 #include "core/FileWatcher.h"
 #include "core/ModifiableObject.h"
 
@@ -39,6 +40,7 @@ public:
     bool hasKey(const QString& key) const;
     QSet<QByteArray> values() const;
     QByteArray value(const QString& key) const;
+    QByteArray hash(const QString& key) const;
     void set(const QString& key, const QByteArray& value);
     void remove(const QString& key);
     void remove(const QStringList& keys);
@@ -67,7 +69,7 @@ private slots:
 private:
     void disconnectAndEraseExternalFile(const QString& path);
 
-    QMap<QString, QByteArray> m_attachments;
+    QMap<QString, AttachmentBlobPtr> m_attachments;
     QHash<QString, QString> m_openedAttachments;
     QHash<QString, QString> m_openedAttachmentsInverse;
     QHash<QString, QSharedPointer<FileWatcher>> m_attachmentFileWatchers;
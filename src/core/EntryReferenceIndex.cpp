@@ -0,0 +1,187 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntryReferenceIndex.h"
+
+#include "core/Database.h"
+#include "core/Group.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Length of a UUID in hex as written by Tools::uuidToHex()
+    const int UuidHexLength = 32;
+
+    bool isHexDigit(QChar c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    /**
+     * All UUIDs an entry references. Entry::isAttributeReferenceOf() accepts
+     * the hex of a UUID anywhere in a reference attribute, so every window of
+     * 32 hex digits is taken.
+     */
+    QVector<QUuid> referencedUuids(const Entry* entry)
+    {
+        QVector<QUuid> uuids;
+        for (const QString& key : EntryAttributes::DefaultAttributes) {
+            if (!entry->attributes()->isReference(key)) {
+                continue;
+            }
+
+            const QString value = entry->attributes()->value(key);
+            int run = 0;
+            for (int i = 0; i < value.size(); ++i) {
+                if (!isHexDigit(value[i])) {
+                    run = 0;
+                } else if (++run >= UuidHexLength) {
+                    const auto hex = value.mid(i - UuidHexLength + 1, UuidHexLength).toLatin1();
+                    uuids.append(QUuid::fromRfc4122(QByteArray::fromHex(hex)));
+                }
+            }
+        }
+
+        std::sort(uuids.begin(), uuids.end());
+        uuids.erase(std::unique(uuids.begin(), uuids.end()), uuids.end());
+        return uuids;
+    }
+} // namespace
+
+EntryReferenceIndex::EntryReferenceIndex(Database* db)
+    : QObject(db)
+    , m_db(db)
+{
+}
+
+bool EntryReferenceIndex::isBuilt() const
+{
+    return m_built;
+}
+
+/**
+ * Returns the entries whose default attributes reference the given UUID.
+ * History items are not included.
+ */
+QList<Entry*> EntryReferenceIndex::referencesTo(const QUuid& uuid)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_built) {
+        build();
+    }
+
+    for (Entry* entry : asConst(m_dirtyEntries)) {
+        unindexEntry(entry);
+        indexEntry(entry);
+    }
+    m_dirtyEntries.clear();
+
+    return m_referrers.value(uuid).values();
+}
+
+void EntryReferenceIndex::addEntry(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_built && !m_references.contains(entry)) {
+        watchEntry(entry);
+        indexEntry(entry);
+    }
+}
+
+void EntryReferenceIndex::removeEntry(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_built && m_references.contains(entry)) {
+        disconnect(entry->attributes(), nullptr, this, nullptr);
+        unindexEntry(entry);
+        m_dirtyEntries.remove(entry);
+    }
+}
+
+/**
+ * Drops the index, it is rebuilt on the next lookup. Used when the
+ * root group is replaced or entries changed while the modified signals
+ * of the database were blocked.
+ */
+void EntryReferenceIndex::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_built) {
+        return;
+    }
+
+    for (auto it = m_references.constBegin(); it != m_references.constEnd(); ++it) {
+        disconnect(it.key()->attributes(), nullptr, this, nullptr);
+    }
+    m_referrers.clear();
+    m_references.clear();
+    m_dirtyEntries.clear();
+    m_built = false;
+}
+
+void EntryReferenceIndex::build()
+{
+    if (m_db->rootGroup()) {
+        for (Entry* entry : m_db->rootGroup()->entriesRecursive()) {
+            watchEntry(entry);
+            indexEntry(entry);
+        }
+    }
+    m_built = true;
+}
+
+/**
+ * Only the default attributes are indexed. Their signals are emitted even
+ * while modified signals are blocked, so saving the database keeps the index.
+ */
+void EntryReferenceIndex::watchEntry(Entry* entry)
+{
+    const auto attributes = entry->attributes();
+    connect(attributes, &EntryAttributes::defaultKeyModified, this, [this, entry] { markDirty(entry); });
+    connect(attributes, &EntryAttributes::reset, this, [this, entry] { markDirty(entry); });
+}
+
+void EntryReferenceIndex::markDirty(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dirtyEntries.insert(entry);
+}
+
+void EntryReferenceIndex::indexEntry(Entry* entry)
+{
+    const QVector<QUuid> uuids = referencedUuids(entry);
+    for (const QUuid& uuid : uuids) {
+        m_referrers[uuid].insert(entry);
+    }
+    m_references.insert(entry, uuids);
+}
+
+void EntryReferenceIndex::unindexEntry(const Entry* entry)
+{
+    const QVector<QUuid> uuids = m_references.take(entry);
+    for (const QUuid& uuid : uuids) {
+        auto it = m_referrers.find(uuid);
+        if (it != m_referrers.end()) {
+            it->remove(const_cast<Entry*>(entry));
+            if (it->isEmpty()) {
+                m_referrers.erase(it);
+            }
+        }
+    }
+}
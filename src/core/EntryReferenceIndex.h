@@ -0,0 +1,70 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ENTRYREFERENCEINDEX_H
+#define KEEPASSXC_ENTRYREFERENCEINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QUuid>
+#include <QVector>
+
+class Database;
+class Entry;
+
+/**
+ * Reverse index from an entry UUID to the entries whose default
+ * attributes reference it, as checked by Entry::hasReferencesTo().
+ *
+ * The index is built on first use and kept up to date from the attribute
+ * signals of the entries afterwards, so looking up the references to an entry only
+ * costs as much as the number of references.
+ */
+class EntryReferenceIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EntryReferenceIndex(Database* db);
+
+    QList<Entry*> referencesTo(const QUuid& uuid);
+    bool isBuilt() const;
+
+public slots:
+    void addEntry(Entry* entry);
+    void removeEntry(Entry* entry);
+    void reset();
+
+private:
+    void build();
+    void indexEntry(Entry* entry);
+    void unindexEntry(const Entry* entry);
+    void watchEntry(Entry* entry);
+    void markDirty(Entry* entry);
+
+    Database* m_db;
+    bool m_built = false;
+    // Referenced UUID to the entries referencing it
+    QHash<QUuid, QSet<Entry*>> m_referrers;
+    QHash<const Entry*, QVector<QUuid>> m_references;
+    QSet<Entry*> m_dirtyEntries;
+    QMutex m_mutex;
+};
+
+#endif // KEEPASSXC_ENTRYREFERENCEINDEX_H
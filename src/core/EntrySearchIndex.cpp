@@ -0,0 +1,388 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntrySearchIndex.h"
+
+#include "core/AsyncTask.h"
+#include "core/Database.h"
+#include "core/Group.h"
+
+#include <algorithm>
+
+namespace
+{
+    enum IndexedField
+    {
+        TitleField = 1 << 0,
+        UsernameField = 1 << 1,
+        UrlField = 1 << 2,
+        NotesField = 1 << 3,
+        TagsField = 1 << 4
+    };
+
+    // Fields that are matched after resolving placeholders
+    const int ResolvedFields = TitleField | UsernameField | UrlField | TagsField;
+
+    int fieldsOfTerm(EntrySearcher::Field field)
+    {
+        switch (field) {
+        case EntrySearcher::Field::Undefined:
+            return TitleField | UsernameField | UrlField | NotesField | TagsField;
+        case EntrySearcher::Field::Title:
+            return TitleField;
+        case EntrySearcher::Field::Username:
+            return UsernameField;
+        case EntrySearcher::Field::Url:
+            return UrlField;
+        case EntrySearcher::Field::Notes:
+            return NotesField;
+        case EntrySearcher::Field::Tag:
+            return TagsField;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * Lower case ASCII character of c, or 0 if c is not ASCII. The
+     * Kelvin sign and the long s match 'k' and 's' in case insensitive
+     * regular expressions, so they are folded as well.
+     */
+    char foldedAscii(QChar c)
+    {
+        const ushort code = c.unicode();
+        if (code == 0x212A) {
+            return 'k';
+        } else if (code == 0x017F) {
+            return 's';
+        } else if (code == 0 || code >= 0x80) {
+            return 0;
+        } else if (code >= 'A' && code <= 'Z') {
+            return static_cast<char>(code - 'A' + 'a');
+        }
+        return static_cast<char>(code);
+    }
+
+    /**
+     * Appends the trigrams of all windows of three ASCII characters in
+     * text. Windows containing other characters are skipped, so a
+     * substring of text always yields a subset of the trigrams of text.
+     */
+    void appendTrigrams(const QString& text, QVector<quint32>& trigrams)
+    {
+        quint32 window = 0;
+        int length = 0;
+        for (const QChar c : text) {
+            const char folded = foldedAscii(c);
+            if (folded == 0) {
+                length = 0;
+                continue;
+            }
+            window = ((window << 8) | static_cast<quint8>(folded)) & 0xFFFFFF;
+            if (++length >= 3) {
+                trigrams.append(window);
+            }
+        }
+    }
+
+    // Indexed fields of an entry, in the order of the IndexedField bits
+    QStringList indexedFields(const Entry* entry)
+    {
+        return {entry->title(), entry->username(), entry->url(), entry->notes(), entry->tags()};
+    }
+} // namespace
+
+EntrySearchIndex::EntrySearchIndex(Database* db)
+    : QObject(db)
+    , m_db(db)
+{
+}
+
+bool EntrySearchIndex::isBuilt() const
+{
+    return m_built;
+}
+
+/**
+ * Collects the entries that can match all the given search terms.
+ * The first call starts building the index in the background.
+ *
+ * @param searchTerms search terms as used by EntrySearcher
+ * @param candidates receives a superset of the matching entries
+ * @return false if the terms cannot be narrowed down by the index
+ *         or the index is not built yet, in which case every entry
+ *         has to be searched
+ */
+bool EntrySearchIndex::findCandidates(const QList<EntrySearcher::SearchTerm>& searchTerms,
+                                      QSet<const Entry*>& candidates)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_built) {
+        if (!m_building) {
+            startBuild();
+        }
+        return false;
+    }
+
+    for (Entry* entry : asConst(m_dirtyEntries)) {
+        m_index.unindexEntry(entry);
+        m_index.indexEntry(entry, indexedFields(entry));
+    }
+    m_dirtyEntries.clear();
+
+    bool filtered = false;
+    for (const auto& term : searchTerms) {
+        QSet<const Entry*> termCandidates;
+        if (!findTermCandidates(term, termCandidates)) {
+            continue;
+        }
+
+        if (filtered) {
+            candidates.intersect(termCandidates);
+        } else {
+            candidates = termCandidates;
+            filtered = true;
+        }
+    }
+
+    return filtered;
+}
+
+bool EntrySearchIndex::findTermCandidates(const EntrySearcher::SearchTerm& term, QSet<const Entry*>& candidates) const
+{
+    const int fields = fieldsOfTerm(term.field);
+    if (fields == 0 || term.exclude) {
+        return false;
+    }
+
+    QVector<quint32> trigrams;
+    for (const QString& literal : term.literals) {
+        appendTrigrams(literal, trigrams);
+    }
+    if (trigrams.isEmpty()) {
+        return false;
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+    // Intersect the posting lists starting from the shortest one
+    QVector<const QHash<const Entry*, int>*> postings;
+    bool missing = false;
+    for (quint32 trigram : asConst(trigrams)) {
+        auto it = m_index.postings.constFind(trigram);
+        if (it == m_index.postings.constEnd()) {
+            missing = true;
+            break;
+        }
+        postings.append(&it.value());
+    }
+
+    if (!missing) {
+        std::sort(postings.begin(), postings.end(), [](const auto* lhs, const auto* rhs) {
+            return lhs->size() < rhs->size();
+        });
+
+        const auto& shortest = *postings.first();
+        for (auto it = shortest.constBegin(); it != shortest.constEnd(); ++it) {
+            // All trigrams have to occur in the same field
+            int entryFields = it.value() & fields;
+            for (int i = 1; i < postings.size() && entryFields != 0; ++i) {
+                entryFields &= postings[i]->value(it.key(), 0);
+            }
+            if (entryFields != 0) {
+                candidates.insert(it.key());
+            }
+        }
+    }
+
+    for (auto it = m_index.unresolvedEntries.constBegin(); it != m_index.unresolvedEntries.constEnd(); ++it) {
+        if (it.value() & fields) {
+            candidates.insert(it.key());
+        }
+    }
+
+    return true;
+}
+
+void EntrySearchIndex::addEntry(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    if ((!m_built && !m_building) || m_watchedEntries.contains(entry)) {
+        return;
+    }
+
+    watchEntry(entry);
+    if (m_built) {
+        m_index.indexEntry(entry, indexedFields(entry));
+    } else {
+        // Indexed once the build finished
+        m_dirtyEntries.insert(entry);
+    }
+}
+
+void EntrySearchIndex::removeEntry(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_watchedEntries.contains(entry)) {
+        return;
+    }
+
+    unwatchEntry(entry);
+    m_index.unindexEntry(entry);
+    m_dirtyEntries.remove(entry);
+    if (m_building) {
+        m_removedEntries.insert(entry);
+    }
+}
+
+/**
+ * Drops the index, it is rebuilt on the next search. Used when the root
+ * group is replaced or entries changed while the modified signals of the
+ * database were blocked.
+ */
+void EntrySearchIndex::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_built && !m_building) {
+        return;
+    }
+
+    for (Entry* entry : asConst(m_watchedEntries)) {
+        disconnect(entry, nullptr, this, nullptr);
+        disconnect(entry->attributes(), nullptr, this, nullptr);
+    }
+    m_watchedEntries.clear();
+    m_index = Index();
+    m_dirtyEntries.clear();
+    m_removedEntries.clear();
+    m_built = false;
+    m_building = false;
+    ++m_buildId;
+}
+
+/**
+ * Takes a copy of the indexed fields and computes their trigrams on the
+ * global thread pool. Entries changing meanwhile are re-indexed once the
+ * build finished.
+ */
+void EntrySearchIndex::startBuild()
+{
+    QVector<QPair<const Entry*, QStringList>> fields;
+    if (m_db->rootGroup()) {
+        for (Entry* entry : m_db->rootGroup()->entriesRecursive()) {
+            watchEntry(entry);
+            fields.append({entry, indexedFields(entry)});
+        }
+    }
+
+    m_building = true;
+    const int buildId = m_buildId;
+    AsyncTask::runThenCallback(
+        [fields] {
+            Index index;
+            for (const auto& entryFields : fields) {
+                index.indexEntry(entryFields.first, entryFields.second);
+            }
+            return index;
+        },
+        this,
+        [this, buildId](const Index& index) { finishBuild(buildId, index); });
+}
+
+void EntrySearchIndex::finishBuild(int buildId, const Index& index)
+{
+    QMutexLocker locker(&m_mutex);
+    if (buildId != m_buildId) {
+        return;
+    }
+
+    m_index = index;
+    for (const Entry* entry : asConst(m_removedEntries)) {
+        m_index.unindexEntry(entry);
+    }
+    m_removedEntries.clear();
+    m_building = false;
+    m_built = true;
+}
+
+/**
+ * Changes of the entry attributes are signalled even while modified signals
+ * are blocked, the tags are covered by the modified signal of the entry.
+ */
+void EntrySearchIndex::watchEntry(Entry* entry)
+{
+    m_watchedEntries.insert(entry);
+    connect(entry, &Entry::modified, this, [this, entry] { markDirty(entry); });
+    connect(entry->attributes(), &EntryAttributes::defaultKeyModified, this, [this, entry] { markDirty(entry); });
+    connect(entry->attributes(), &EntryAttributes::reset, this, [this, entry] { markDirty(entry); });
+}
+
+void EntrySearchIndex::unwatchEntry(Entry* entry)
+{
+    m_watchedEntries.remove(entry);
+    disconnect(entry, nullptr, this, nullptr);
+    disconnect(entry->attributes(), nullptr, this, nullptr);
+}
+
+void EntrySearchIndex::markDirty(Entry* entry)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dirtyEntries.insert(entry);
+}
+
+void EntrySearchIndex::Index::indexEntry(const Entry* entry, const QStringList& fields)
+{
+    IndexedEntry indexed;
+    QVector<quint32> trigrams;
+    for (int i = 0; i < fields.size(); ++i) {
+        const int field = 1 << i;
+        if ((field & ResolvedFields) && fields[i].contains('{')) {
+            indexed.unresolvedFields |= field;
+        }
+
+        trigrams.clear();
+        appendTrigrams(fields[i], trigrams);
+        for (quint32 trigram : asConst(trigrams)) {
+            int& entryFields = postings[trigram][entry];
+            if (entryFields == 0) {
+                indexed.trigrams.append(trigram);
+            }
+            entryFields |= field;
+        }
+    }
+
+    if (indexed.unresolvedFields != 0) {
+        unresolvedEntries.insert(entry, indexed.unresolvedFields);
+    }
+    entries.insert(entry, indexed);
+}
+
+void EntrySearchIndex::Index::unindexEntry(const Entry* entry)
+{
+    const IndexedEntry indexed = entries.take(entry);
+    for (quint32 trigram : indexed.trigrams) {
+        auto it = postings.find(trigram);
+        if (it != postings.end()) {
+            it->remove(entry);
+            if (it->isEmpty()) {
+                postings.erase(it);
+            }
+        }
+    }
+    unresolvedEntries.remove(entry);
+}
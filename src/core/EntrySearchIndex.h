@@ -0,0 +1,95 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ENTRYSEARCHINDEX_H
+#define KEEPASSXC_ENTRYSEARCHINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+#include "core/EntrySearcher.h"
+
+class Database;
+class Entry;
+
+/**
+ * Trigram index over the title, username, url, notes and tags of all
+ * entries of a database. It narrows down the entries a search has to
+ * match against, the final decision is always made by EntrySearcher.
+ *
+ * The index is built in the background on first use, searches run
+ * unfiltered until it is ready. Afterwards it is kept up to date from
+ * the entry signals.
+ */
+class EntrySearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EntrySearchIndex(Database* db);
+
+    bool findCandidates(const QList<EntrySearcher::SearchTerm>& searchTerms, QSet<const Entry*>& candidates);
+    bool isBuilt() const;
+
+public slots:
+    void addEntry(Entry* entry);
+    void removeEntry(Entry* entry);
+    void reset();
+
+private:
+    struct IndexedEntry
+    {
+        QVector<quint32> trigrams;
+        int unresolvedFields = 0;
+    };
+
+    struct Index
+    {
+        // Trigram to the entries containing it, with a bit per field it occurs in
+        QHash<quint32, QHash<const Entry*, int>> postings;
+        QHash<const Entry*, IndexedEntry> entries;
+        // Entries with fields that contain placeholders, these match any trigram
+        QHash<const Entry*, int> unresolvedEntries;
+
+        void indexEntry(const Entry* entry, const QStringList& fields);
+        void unindexEntry(const Entry* entry);
+    };
+
+    void startBuild();
+    void finishBuild(int buildId, const Index& index);
+    void watchEntry(Entry* entry);
+    void unwatchEntry(Entry* entry);
+    void markDirty(Entry* entry);
+    bool findTermCandidates(const EntrySearcher::SearchTerm& term, QSet<const Entry*>& candidates) const;
+
+    Database* m_db;
+    bool m_built = false;
+    bool m_building = false;
+    // Builds finishing with another id were started before the last reset
+    int m_buildId = 0;
+    Index m_index;
+    QSet<Entry*> m_watchedEntries;
+    QSet<Entry*> m_dirtyEntries;
+    // Entries removed while the index was built
+    QSet<const Entry*> m_removedEntries;
+    QMutex m_mutex;
+};
+
+#endif // KEEPASSXC_ENTRYSEARCHINDEX_H
@@ -19,12 +19,50 @@
 #include "EntrySearcher.h"
 
 #include "PasswordHealth.h"
+#include "core/EntrySearchIndex.h"
 #include "core/Group.h"
 #include "core/Tools.h"
 
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace
+{
+    // Searches over fewer entries are not worth the overhead of the thread pool
+    const int ParallelSearchMinimumEntries = 2048;
+
+    // Relative cost of matching a term, used to evaluate cheap terms first
+    int termCost(const EntrySearcher::SearchTerm& term)
+    {
+        switch (term.field) {
+        case EntrySearcher::Field::Title:
+        case EntrySearcher::Field::Username:
+        case EntrySearcher::Field::Password:
+        case EntrySearcher::Field::Url:
+        case EntrySearcher::Field::Tag:
+            return 0;
+        case EntrySearcher::Field::Notes:
+        case EntrySearcher::Field::AttributeValue:
+        case EntrySearcher::Field::Group:
+            return 1;
+        case EntrySearcher::Field::Attachment:
+        case EntrySearcher::Field::Undefined:
+            return 2;
+        case EntrySearcher::Field::AttributeKV:
+            return 3;
+        default:
+            return 4;
+        }
+    }
+} // namespace
+
 EntrySearcher::EntrySearcher(bool caseSensitive, bool skipProtected)
     : m_caseSensitive(caseSensitive)
     , m_skipProtected(skipProtected)
+    , m_parallel(false)
+    , m_indexed(false)
     , m_termParser(R"re(([-!*+]+)?(?:(\w*):)?(?:(?=")"((?:[^"\\]|\\.)*)"|([^ ]*))( |$))re")
 // Group 1 = modifiers, Group 2 = field, Group 3 = quoted string, Group 4 = unquoted string
 {
@@ -71,17 +109,22 @@ QList<Entry*> EntrySearcher::repeat(const Group* baseGroup, bool forceSearch)
 {
     Q_ASSERT(baseGroup);
 
-    QList<Entry*> results;
+    // Only entries found by the search index of the database can match
+    QSet<const Entry*> candidates;
+    auto db = baseGroup->database();
+    const bool filtered = m_indexed && db && db->searchIndex()->findCandidates(m_searchTerms, candidates);
+
+    QList<Entry*> entries;
     for (const auto group : baseGroup->groupsRecursive(true)) {
         if (forceSearch || group->resolveSearchingEnabled()) {
             for (const auto entry : group->entries()) {
-                if (searchEntryImpl(entry)) {
-                    results.append(entry);
+                if (!filtered || candidates.contains(entry)) {
+                    entries.append(entry);
                 }
             }
         }
     }
-    return results;
+    return repeatEntries(entries);
 }
 
 /**
@@ -118,11 +161,38 @@ QList<Entry*> EntrySearcher::searchEntries(const QString& searchString, const QL
  * @return list of entries that match the search terms
  */
 QList<Entry*> EntrySearcher::repeatEntries(const QList<Entry*>& entries)
+{
+    compileSearchTerms();
+
+    if (!m_parallel || entries.size() < ParallelSearchMinimumEntries) {
+        return searchRange(entries, 0, entries.size());
+    }
+
+    // Split the entries into consecutive ranges and search each range on the thread pool,
+    // every task works on its own copy of the searcher
+    const int rangeSize = qMax(ParallelSearchMinimumEntries / 4, entries.size() / (QThread::idealThreadCount() * 4));
+    QList<QFuture<QList<Entry*>>> futures;
+    for (int begin = 0; begin < entries.size(); begin += rangeSize) {
+        const int end = qMin(begin + rangeSize, entries.size());
+        futures.append(QtConcurrent::run([searcher = *this, &entries, begin, end]() mutable {
+            return searcher.searchRange(entries, begin, end);
+        }));
+    }
+
+    // Merge in order of the ranges to keep the order of the entries
+    QList<Entry*> results;
+    for (auto& future : futures) {
+        results.append(future.result());
+    }
+    return results;
+}
+
+QList<Entry*> EntrySearcher::searchRange(const QList<Entry*>& entries, int begin, int end)
 {
     QList<Entry*> results;
-    for (auto* entry : entries) {
-        if (searchEntryImpl(entry)) {
-            results.append(entry);
+    for (int i = begin; i < end; ++i) {
+        if (searchEntryImpl(entries[i])) {
+            results.append(entries[i]);
         }
     }
     return results;
@@ -143,42 +213,105 @@ bool EntrySearcher::isCaseSensitive() const
     return m_caseSensitive;
 }
 
+/**
+ * Spread searches over large numbers of entries across the global thread pool
+ *
+ * @param state
+ */
+void EntrySearcher::setParallel(bool state)
+{
+    m_parallel = state;
+}
+
+bool EntrySearcher::isParallel() const
+{
+    return m_parallel;
+}
+
+/**
+ * Narrow down searches of groups through the search index of their database.
+ * Only worth it for searchers that are used repeatedly, the index is built
+ * in the background on the first search.
+ *
+ * @param state
+ */
+void EntrySearcher::setIndexed(bool state)
+{
+    m_indexed = state;
+}
+
+bool EntrySearcher::isIndexed() const
+{
+    return m_indexed;
+}
+
+/**
+ * Order the search terms cheapest first, all of them have to match
+ * so the order does not change the result.
+ */
+void EntrySearcher::compileSearchTerms()
+{
+    m_plan = m_searchTerms;
+    std::stable_sort(m_plan.begin(), m_plan.end(), [](const SearchTerm& lhs, const SearchTerm& rhs) {
+        return termCost(lhs) < termCost(rhs);
+    });
+    m_groupHierarchies.clear();
+}
+
+const QString& EntrySearcher::groupHierarchy(const Group* group)
+{
+    auto it = m_groupHierarchies.find(group);
+    if (it == m_groupHierarchies.end()) {
+        // Build a group hierarchy to allow searching for e.g. /group1/subgroup*
+        it = m_groupHierarchies.insert(group, group->hierarchy().join('/').prepend("/"));
+    }
+    return it.value();
+}
+
 bool EntrySearcher::searchEntryImpl(const Entry* entry)
 {
-    // Pre-load in case they are needed
-    auto attributes_keys = entry->attributes()->customKeys();
-    auto attributes = QStringList(attributes_keys + entry->attributes()->values(attributes_keys));
-    auto attachments = QStringList(entry->attachments()->keys());
-    // Build a group hierarchy to allow searching for e.g. /group1/subgroup*
-    auto hierarchy = entry->group()->hierarchy().join('/').prepend("/");
+    // Only load attributes and attachments when a term needs them
+    QStringList attributes;
+    bool attributesLoaded = false;
+    QStringList attachments;
+    bool attachmentsLoaded = false;
 
     // By default, empty term matches every entry.
     // However when skipping protected fields, we will reject everything instead
     bool found = !m_skipProtected;
-    for (const auto& term : m_searchTerms) {
+    for (const auto& term : asConst(m_plan)) {
         switch (term.field) {
         case Field::Title:
-            found = term.regex.match(entry->resolvePlaceholder(entry->title())).hasMatch();
+            found = term.regex.match(entry->resolvedTitle()).hasMatch();
             break;
         case Field::Username:
-            found = term.regex.match(entry->resolvePlaceholder(entry->username())).hasMatch();
+            found = term.regex.match(entry->resolvedUsername()).hasMatch();
             break;
         case Field::Password:
             if (m_skipProtected) {
                 continue;
             }
-            found = term.regex.match(entry->resolvePlaceholder(entry->password())).hasMatch();
+            found = term.regex.match(entry->resolvedPassword()).hasMatch();
             break;
         case Field::Url:
-            found = term.regex.match(entry->resolvePlaceholder(entry->url())).hasMatch();
+            found = term.regex.match(entry->resolvedUrl()).hasMatch();
             break;
         case Field::Notes:
             found = term.regex.match(entry->notes()).hasMatch();
             break;
         case Field::AttributeKV:
+            if (!attributesLoaded) {
+                const auto keys = entry->attributes()->customKeys();
+                attributes = keys + entry->attributes()->values(keys);
+                attributesLoaded = true;
+            }
             found = !attributes.filter(term.regex).empty();
             break;
         case Field::Attachment:
+            if (!attachmentsLoaded) {
+                attachments = entry->attachments()->keys();
+                attachmentsLoaded = true;
+            }
             found = !attachments.filter(term.regex).empty();
             break;
         case Field::AttributeValue:
@@ -191,7 +324,7 @@ bool EntrySearcher::searchEntryImpl(const Entry* entry)
         case Field::Group:
             // Match against the full hierarchy if the word contains a '/' otherwise just the group name
             if (term.word.contains('/')) {
-                found = term.regex.match(hierarchy).hasMatch();
+                found = term.regex.match(groupHierarchy(entry->group())).hasMatch();
             } else {
                 found = term.regex.match(entry->group()->name()).hasMatch();
             }
@@ -217,9 +350,9 @@ bool EntrySearcher::searchEntryImpl(const Entry* entry)
             break;
         default:
             // Terms without a specific field try to match title, username, url, and notes
-            found = term.regex.match(entry->resolvePlaceholder(entry->title())).hasMatch()
-                    || term.regex.match(entry->resolvePlaceholder(entry->username())).hasMatch()
-                    || term.regex.match(entry->resolvePlaceholder(entry->url())).hasMatch()
+            found = term.regex.match(entry->resolvedTitle()).hasMatch()
+                    || term.regex.match(entry->resolvedUsername()).hasMatch()
+                    || term.regex.match(entry->resolvedUrl()).hasMatch()
                     || term.regex.match(entry->resolvePlaceholder(entry->tags())).hasMatch()
                     || term.regex.match(entry->notes()).hasMatch();
         }
@@ -286,6 +419,11 @@ void EntrySearcher::parseSearchTerms(const QString& searchString)
         }
         term.regex = Tools::convertToRegex(term.word, opts);
 
+        // Text between wildcards has to occur literally, unless alternatives are given
+        if (!mods.contains("*") && !term.word.contains('|')) {
+            term.literals = term.word.split(QRegularExpression("[*?]"), QString::SkipEmptyParts);
+        }
+
         // Exclude modifier
         term.exclude = mods.contains("-") || mods.contains("!");
 
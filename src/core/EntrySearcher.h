@@ -19,6 +19,7 @@
 #ifndef KEEPASSX_ENTRYSEARCHER_H
 #define KEEPASSX_ENTRYSEARCHER_H
 
+#include <QHash>
 #include <QRegularExpression>
 
 class Group;
@@ -50,6 +51,8 @@ public:
         QString word;
         QRegularExpression regex;
         bool exclude;
+        // substrings every match of regex contains, used to narrow down the search
+        QStringList literals;
     };
 
     explicit EntrySearcher(bool caseSensitive = false, bool skipProtected = false);
@@ -64,15 +67,27 @@ public:
 
     void setCaseSensitive(bool state);
     bool isCaseSensitive() const;
+    void setParallel(bool state);
+    bool isParallel() const;
+    void setIndexed(bool state);
+    bool isIndexed() const;
 
 private:
+    QList<Entry*> searchRange(const QList<Entry*>& entries, int begin, int end);
     bool searchEntryImpl(const Entry* entry);
     void parseSearchTerms(const QString& searchString);
+    void compileSearchTerms();
+    const QString& groupHierarchy(const Group* group);
 
     bool m_caseSensitive;
     bool m_skipProtected;
+    bool m_parallel;
+    bool m_indexed;
     QRegularExpression m_termParser;
     QList<SearchTerm> m_searchTerms;
+    // m_searchTerms in evaluation order
+    QList<SearchTerm> m_plan;
+    QHash<const Group*, QString> m_groupHierarchies;
 
     friend class TestEntrySearcher;
 };
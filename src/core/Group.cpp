@@ -20,6 +20,7 @@
 #include "config-keepassx.h"
 
 #include "core/Config.h"
+#include "core/EntryReferenceIndex.h"
 
 #ifdef WITH_XC_KEESHARE
 #include "keeshare/KeeShare.h"
@@ -36,6 +37,19 @@ const int Group::DefaultIconNumber = 48;
 const int Group::RecycleBinIconNumber = 43;
 const QString Group::RootAutoTypeSequence = "{USERNAME}{TAB}{PASSWORD}{ENTER}";
 
+namespace
+{
+    bool isSameOrDescendant(const Group* group, const Group* ancestor)
+    {
+        for (; group; group = group->parentGroup()) {
+            if (group == ancestor) {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
 Group::Group()
     : m_customData(new CustomData(this))
     , m_updateTimeinfo(true)
@@ -309,7 +323,10 @@ bool Group::equals(const Group* other, CompareItemOptions options) const
 
 void Group::setUuid(const QUuid& uuid)
 {
-    set(m_uuid, uuid);
+    const QUuid oldUuid = m_uuid;
+    if (set(m_uuid, uuid) && m_db) {
+        m_db->updateUuidIndex(this, oldUuid);
+    }
 }
 
 void Group::setName(const QString& name)
@@ -574,9 +591,27 @@ QList<Entry*> Group::entriesRecursive(bool includeHistoryItems) const
 
 QList<Entry*> Group::referencesRecursive(const Entry* entry) const
 {
-    auto entries = entriesRecursive();
-    return QtConcurrent::blockingFiltered(entries,
-                                          [entry](const Entry* e) { return e->hasReferencesTo(entry->uuid()); });
+    if (!m_db) {
+        auto entries = entriesRecursive();
+        return QtConcurrent::blockingFiltered(entries,
+                                              [entry](const Entry* e) { return e->hasReferencesTo(entry->uuid()); });
+    }
+
+    auto references = m_db->entryReferenceIndex()->referencesTo(entry->uuid());
+    if (this != m_db->rootGroup()) {
+        // Only keep the references inside of this group
+        references.erase(std::remove_if(references.begin(),
+                                        references.end(),
+                                        [this](const Entry* e) {
+                                            const Group* group = e->group();
+                                            while (group && group != this) {
+                                                group = group->parentGroup();
+                                            }
+                                            return !group;
+                                        }),
+                         references.end());
+    }
+    return references;
 }
 
 Entry* Group::findEntryByUuid(const QUuid& uuid, bool recursive) const
@@ -585,6 +620,19 @@ Entry* Group::findEntryByUuid(const QUuid& uuid, bool recursive) const
         return nullptr;
     }
 
+    if (isUuidIndexed()) {
+        const auto candidates = m_db->entriesByUuid(uuid);
+        // Duplicate UUIDs are left to the tree walk below, so the first entry in tree order wins
+        if (candidates.size() <= 1) {
+            for (auto entry : candidates) {
+                if (entry->group() == this || (recursive && isSameOrDescendant(entry->group(), this))) {
+                    return entry;
+                }
+            }
+            return nullptr;
+        }
+    }
+
     auto entries = m_entries;
     if (recursive) {
         entries = entriesRecursive(false);
@@ -611,6 +659,10 @@ Entry* Group::findEntryByPath(const QString& entryPath) const
     if (!normalizedEntryPath.startsWith("/") && normalizedEntryPath.contains("/")) {
         normalizedEntryPath = "/" + normalizedEntryPath;
     }
+
+    if (m_db && m_db->rootGroup() == this) {
+        return m_db->entryByPath(normalizedEntryPath);
+    }
     return findEntryByPathRecursive(normalizedEntryPath, "/");
 }
 
@@ -620,6 +672,12 @@ Entry* Group::findEntryBySearchTerm(const QString& term, EntryReferenceType refe
                "Database::findEntryRecursive",
                "Can't search entry with \"referenceType\" parameter equal to \"Unknown\"");
 
+    if (m_db && m_db->rootGroup() == this) {
+        return m_db->entryByReference(term, referenceType);
+    } else if (referenceType == EntryReferenceType::QUuid) {
+        return findEntryByUuid(QUuid::fromRfc4122(QByteArray::fromHex(term.toLatin1())));
+    }
+
     const QList<Group*> groups = groupsRecursive(true);
 
     for (const Group* group : groups) {
@@ -698,6 +756,10 @@ Group* Group::findGroupByPath(const QString& groupPath)
             + (groupPath.endsWith("/") ? "" : "/");
         // clang-format on
     }
+
+    if (m_db && m_db->rootGroup() == this) {
+        return m_db->groupByPath(normalizedGroupPath);
+    }
     return findGroupByPathRecursive(normalizedGroupPath, "/");
 }
 
@@ -844,17 +906,7 @@ QList<QString> Group::usernamesRecursive(int topN) const
 
 Group* Group::findGroupByUuid(const QUuid& uuid)
 {
-    if (uuid.isNull()) {
-        return nullptr;
-    }
-
-    for (Group* group : groupsRecursive(true)) {
-        if (group->uuid() == uuid) {
-            return group;
-        }
-    }
-
-    return nullptr;
+    return const_cast<Group*>(static_cast<const Group*>(this)->findGroupByUuid(uuid));
 }
 
 const Group* Group::findGroupByUuid(const QUuid& uuid) const
@@ -863,6 +915,18 @@ const Group* Group::findGroupByUuid(const QUuid& uuid) const
         return nullptr;
     }
 
+    if (isUuidIndexed()) {
+        const auto candidates = m_db->groupsByUuid(uuid);
+        if (candidates.size() <= 1) {
+            for (const Group* group : candidates) {
+                if (isSameOrDescendant(group, this)) {
+                    return group;
+                }
+            }
+            return nullptr;
+        }
+    }
+
     for (const Group* group : groupsRecursive(true)) {
         if (group->uuid() == uuid) {
             return group;
@@ -1029,6 +1093,10 @@ void Group::connectDatabaseSignalsRecursive(Database* db)
         connect(this, &Group::groupMoved, db, &Database::groupMoved);
         connect(this, &Group::groupNonDataChange, db, &Database::markNonDataChange);
         connect(this, &Group::modified, db, &Database::markAsModified);
+        connect(this, &Group::groupAboutToAdd, db, &Database::addGroupToIndex);
+        connect(this, &Group::groupAboutToRemove, db, &Database::removeGroupFromIndex);
+        connect(this, &Group::entryAdded, db, &Database::addEntryToIndex);
+        connect(this, &Group::entryAboutToRemove, db, &Database::removeEntryFromIndex);
         // clang-format on
     }
 
@@ -1039,6 +1107,23 @@ void Group::connectDatabaseSignalsRecursive(Database* db)
     }
 }
 
+/**
+ * Returns true if the group belongs to the group tree of its database,
+ * in which case the database UUID index covers the group and its children.
+ */
+bool Group::isUuidIndexed() const
+{
+    if (!m_db) {
+        return false;
+    }
+
+    const Group* root = this;
+    while (root->m_parent) {
+        root = root->m_parent;
+    }
+    return root == m_db->rootGroup();
+}
+
 void Group::cleanupParent()
 {
     if (m_parent) {
@@ -209,6 +209,7 @@ private:
     void setParent(Database* db);
 
     void connectDatabaseSignalsRecursive(Database* db);
+    bool isUuidIndexed() const;
     void cleanupParent();
     void recCreateDelObjects();
 
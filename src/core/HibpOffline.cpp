@@ -20,11 +20,45 @@
 #include "core/Group.h"
 
 #include <QCryptographicHash>
+#include <QFile>
 #include <QProcess>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 namespace HibpOffline
 {
     const std::size_t SHA1_BYTES = 20;
+    const std::size_t SHA1_HEX_CHARS = SHA1_BYTES * 2;
+
+    // Number of evenly spaced lines that must be in ascending order
+    // before a mapped HIBP file is searched with bisection
+    const int SORT_CHECK_SAMPLES = 64;
+
+    /*
+     * Binary index layout, all integers little endian:
+     *
+     *   header   magic (8 bytes), version (u32), reserved (u32),
+     *            number of records (u64), reserved (u64)
+     *   buckets  65537 x index of the first record (u64),
+     *            one bucket per 16-bit hash prefix plus an end marker
+     *   records  SHA-1 hash without its 2-byte bucket prefix followed by
+     *            the leak count (u32), sorted by hash
+     *
+     * Records have a fixed size, so a lookup bisects its bucket directly.
+     */
+    const char INDEX_MAGIC[] = "KPXCHIBP";
+    const int INDEX_MAGIC_SIZE = 8;
+    const quint32 INDEX_VERSION = 2;
+    const int INDEX_HEADER_SIZE = 32;
+    const int INDEX_BUCKETS = 0x10000;
+    const int INDEX_BUCKET_ENTRY_SIZE = 8;
+    const int INDEX_PREFIX_BYTES = 2;
+    const int INDEX_HASH_SIZE = SHA1_BYTES - INDEX_PREFIX_BYTES;
+    const int INDEX_RECORD_SIZE = INDEX_HASH_SIZE + 4;
+    const qint64 INDEX_RECORDS_OFFSET = INDEX_HEADER_SIZE + qint64(INDEX_BUCKETS + 1) * INDEX_BUCKET_ENTRY_SIZE;
 
     enum class ParseResult
     {
@@ -75,8 +109,32 @@ namespace HibpOffline
         return ParseResult::Ok;
     }
 
-    bool
-    report(QSharedPointer<Database> db, QIODevice& hibpInput, QList<QPair<const Entry*, int>>& findings, QString* error)
+    int hexValue(char c)
+    {
+        if ('0' <= c && c <= '9') {
+            return c - '0';
+        } else if ('a' <= c && c <= 'f') {
+            return c - 'a' + 10;
+        } else if ('A' <= c && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool decodeSha1Hex(const char* hex, unsigned char* sha1)
+    {
+        for (std::size_t i = 0; i < SHA1_BYTES; ++i) {
+            const int high = hexValue(hex[2 * i]);
+            const int low = hexValue(hex[2 * i + 1]);
+            if (high < 0 || low < 0) {
+                return false;
+            }
+            sha1[i] = static_cast<unsigned char>((high << 4) | low);
+        }
+        return true;
+    }
+
+    QMultiHash<QByteArray, const Entry*> hashEntries(QSharedPointer<Database> db)
     {
         QMultiHash<QByteArray, const Entry*> entriesBySha1;
         for (const auto* entry : db->rootGroup()->entriesRecursive()) {
@@ -85,6 +143,259 @@ namespace HibpOffline
                 entriesBySha1.insert(sha1, entry);
             }
         }
+        return entriesBySha1;
+    }
+
+    /**
+     * Read-only view of a memory mapped HIBP file that is sorted by hash.
+     * Lines have the form "<40 hex digits>:<count>" and are terminated by
+     * LF or CRLF. Any line the view cannot understand makes the lookup
+     * report Fallback, so the caller can use the sequential parser instead.
+     */
+    class MappedHibpFile
+    {
+    public:
+        enum class LookupResult
+        {
+            Found,
+            NotFound,
+            Fallback
+        };
+
+        MappedHibpFile(const char* data, qint64 size)
+            : m_data(data)
+            , m_size(size)
+        {
+        }
+
+        bool isSorted() const
+        {
+            unsigned char previous[SHA1_BYTES];
+            unsigned char current[SHA1_BYTES];
+            bool hasPrevious = false;
+
+            for (int i = 0; i <= SORT_CHECK_SAMPLES; ++i) {
+                const qint64 pos = lineStart(qMin(m_size - 1, m_size * i / SORT_CHECK_SAMPLES), 0);
+                if (!parseLine(pos, current, nullptr, nullptr)) {
+                    return false;
+                }
+                if (hasPrevious && std::memcmp(previous, current, SHA1_BYTES) > 0) {
+                    return false;
+                }
+                std::memcpy(previous, current, SHA1_BYTES);
+                hasPrevious = true;
+            }
+
+            return true;
+        }
+
+        LookupResult lookup(const QByteArray& sha1, int& count) const
+        {
+            Q_ASSERT(sha1.size() == static_cast<int>(SHA1_BYTES));
+            const auto* target = reinterpret_cast<const unsigned char*>(sha1.constData());
+
+            // Both bounds always point to the start of a line. The hashes
+            // seen at the bounds double as a cheap check that the file is
+            // really sorted: no line between them may fall outside their range.
+            qint64 low = 0;
+            qint64 high = m_size;
+            unsigned char lowHash[SHA1_BYTES];
+            unsigned char highHash[SHA1_BYTES];
+            bool hasLowHash = false;
+            bool hasHighHash = false;
+
+            while (low < high) {
+                const qint64 start = lineStart(low + (high - low) / 2, low);
+
+                unsigned char lineHash[SHA1_BYTES];
+                qint64 end;
+                if (!parseLine(start, lineHash, &end, &count)) {
+                    return LookupResult::Fallback;
+                }
+
+                if ((hasLowHash && std::memcmp(lineHash, lowHash, SHA1_BYTES) < 0)
+                    || (hasHighHash && std::memcmp(lineHash, highHash, SHA1_BYTES) > 0)) {
+                    return LookupResult::Fallback;
+                }
+
+                const int cmp = std::memcmp(lineHash, target, SHA1_BYTES);
+                if (cmp == 0) {
+                    return LookupResult::Found;
+                } else if (cmp < 0) {
+                    low = end;
+                    std::memcpy(lowHash, lineHash, SHA1_BYTES);
+                    hasLowHash = true;
+                } else {
+                    high = start;
+                    std::memcpy(highHash, lineHash, SHA1_BYTES);
+                    hasHighHash = true;
+                }
+            }
+
+            return LookupResult::NotFound;
+        }
+
+    private:
+        qint64 lineStart(qint64 pos, qint64 lowerBound) const
+        {
+            while (pos > lowerBound && m_data[pos - 1] != '\n') {
+                --pos;
+            }
+            return pos;
+        }
+
+        bool parseLine(qint64 pos, unsigned char* sha1, qint64* end, int* count) const
+        {
+            if (m_size - pos <= static_cast<qint64>(SHA1_HEX_CHARS)) {
+                return false;
+            }
+
+            if (!decodeSha1Hex(m_data + pos, sha1)) {
+                return false;
+            }
+
+            pos += SHA1_HEX_CHARS;
+            if (m_data[pos++] != ':') {
+                return false;
+            }
+
+            int value = 0;
+            bool hasDigits = false;
+            for (; pos < m_size && '0' <= m_data[pos] && m_data[pos] <= '9'; ++pos) {
+                const int digit = m_data[pos] - '0';
+                if (value > (std::numeric_limits<int>::max() - digit) / 10) {
+                    return false;
+                }
+                value = value * 10 + digit;
+                hasDigits = true;
+            }
+            if (!hasDigits) {
+                return false;
+            }
+
+            if (pos < m_size && m_data[pos] == '\r') {
+                ++pos;
+            }
+            if (pos < m_size) {
+                if (m_data[pos] != '\n') {
+                    return false;
+                }
+                ++pos;
+            }
+
+            if (end) {
+                *end = pos;
+            }
+            if (count) {
+                *count = value;
+            }
+            return true;
+        }
+
+        const char* m_data;
+        qint64 m_size;
+    };
+
+    /**
+     * Read-only view of a memory mapped binary HIBP index as written by buildIndex().
+     */
+    class MappedHibpIndex
+    {
+    public:
+        MappedHibpIndex(const char* data, qint64 size)
+            : m_data(reinterpret_cast<const uchar*>(data))
+            , m_size(size)
+        {
+            if (m_size < INDEX_RECORDS_OFFSET || !hasMagic(data, size)
+                || qFromLittleEndian<quint32>(m_data + INDEX_MAGIC_SIZE) != INDEX_VERSION) {
+                return;
+            }
+
+            m_recordCount = qFromLittleEndian<quint64>(m_data + 16);
+            m_valid = m_recordCount == quint64(m_size - INDEX_RECORDS_OFFSET) / INDEX_RECORD_SIZE
+                      && quint64(m_size - INDEX_RECORDS_OFFSET) % INDEX_RECORD_SIZE == 0;
+        }
+
+        static bool hasMagic(const char* data, qint64 size)
+        {
+            return size >= INDEX_MAGIC_SIZE && std::memcmp(data, INDEX_MAGIC, INDEX_MAGIC_SIZE) == 0;
+        }
+
+        bool isValid() const
+        {
+            return m_valid;
+        }
+
+        bool lookup(const QByteArray& sha1, int& count, bool& found) const
+        {
+            Q_ASSERT(sha1.size() == static_cast<int>(SHA1_BYTES));
+            const auto* target = reinterpret_cast<const uchar*>(sha1.constData());
+            const int bucket = (target[0] << 8) | target[1];
+
+            const uchar* bucketEntry = m_data + INDEX_HEADER_SIZE + qint64(bucket) * INDEX_BUCKET_ENTRY_SIZE;
+            quint64 low = qFromLittleEndian<quint64>(bucketEntry);
+            quint64 high = qFromLittleEndian<quint64>(bucketEntry + INDEX_BUCKET_ENTRY_SIZE);
+            if (low > high || high > m_recordCount) {
+                return false;
+            }
+
+            found = false;
+            while (low < high) {
+                const quint64 mid = low + (high - low) / 2;
+                const uchar* record = m_data + INDEX_RECORDS_OFFSET + mid * INDEX_RECORD_SIZE;
+                const int cmp = std::memcmp(record, target + INDEX_PREFIX_BYTES, INDEX_HASH_SIZE);
+                if (cmp == 0) {
+                    const quint32 value = qFromLittleEndian<quint32>(record + INDEX_HASH_SIZE);
+                    count = static_cast<int>(qMin<quint32>(value, std::numeric_limits<int>::max()));
+                    found = true;
+                    break;
+                } else if (cmp < 0) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+
+            return true;
+        }
+
+    private:
+        const uchar* m_data;
+        qint64 m_size;
+        quint64 m_recordCount = 0;
+        bool m_valid = false;
+    };
+
+    bool indexReport(QSharedPointer<Database> db,
+                     const MappedHibpIndex& index,
+                     QList<QPair<const Entry*, int>>& findings,
+                     QString* error)
+    {
+        const auto entriesBySha1 = hashEntries(db);
+        auto hashes = entriesBySha1.uniqueKeys();
+        std::sort(hashes.begin(), hashes.end());
+
+        for (const auto& sha1 : hashes) {
+            int count = 0;
+            bool found = false;
+            if (!index.lookup(sha1, count, found)) {
+                *error = QObject::tr("HIBP index is corrupted");
+                return false;
+            }
+            if (found) {
+                for (const auto* entry : entriesBySha1.values(sha1)) {
+                    findings.append({entry, count});
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool
+    report(QSharedPointer<Database> db, QIODevice& hibpInput, QList<QPair<const Entry*, int>>& findings, QString* error)
+    {
+        const auto entriesBySha1 = hashEntries(db);
 
         QByteArray sha1;
         for (quint64 lineNum = 1;; ++lineNum) {
@@ -106,6 +417,165 @@ namespace HibpOffline
         }
     }
 
+    bool report(QSharedPointer<Database> db,
+                const QString& hibpFilePath,
+                QList<QPair<const Entry*, int>>& findings,
+                QString* error)
+    {
+        QFile hibpFile(hibpFilePath);
+        if (!hibpFile.open(QFile::ReadOnly)) {
+            *error = QObject::tr("Failed to open HIBP file %1: %2").arg(hibpFilePath, hibpFile.errorString());
+            return false;
+        }
+
+        // Mapping fails on 32-bit platforms for the full dump and for special
+        // files, in which case we simply scan the file sequentially.
+        const qint64 size = hibpFile.size();
+        const auto* data = size > 0 ? reinterpret_cast<const char*>(hibpFile.map(0, size)) : nullptr;
+        if (!data) {
+            if (hibpFile.peek(INDEX_MAGIC_SIZE) == QByteArray(INDEX_MAGIC, INDEX_MAGIC_SIZE)) {
+                *error = QObject::tr("Failed to map HIBP index %1: %2").arg(hibpFilePath, hibpFile.errorString());
+                return false;
+            }
+            return report(db, hibpFile, findings, error);
+        }
+
+        if (MappedHibpIndex::hasMagic(data, size)) {
+            const MappedHibpIndex index(data, size);
+            if (!index.isValid()) {
+                *error = QObject::tr("Unsupported or corrupted HIBP index: %1").arg(hibpFilePath);
+                return false;
+            }
+            return indexReport(db, index, findings, error);
+        }
+
+        const MappedHibpFile mapped(data, size);
+        if (mapped.isSorted()) {
+            const auto entriesBySha1 = hashEntries(db);
+
+            // Report in hash order, just like the sequential scan does
+            auto hashes = entriesBySha1.uniqueKeys();
+            std::sort(hashes.begin(), hashes.end());
+
+            QList<QPair<const Entry*, int>> mappedFindings;
+            bool complete = true;
+            for (const auto& sha1 : hashes) {
+                int count = 0;
+                const auto result = mapped.lookup(sha1, count);
+                if (result == MappedHibpFile::LookupResult::Fallback) {
+                    complete = false;
+                    break;
+                } else if (result == MappedHibpFile::LookupResult::Found) {
+                    for (const auto* entry : entriesBySha1.values(sha1)) {
+                        mappedFindings.append({entry, count});
+                    }
+                }
+            }
+
+            if (complete) {
+                findings.append(mappedFindings);
+                return true;
+            }
+        }
+
+        // The file is not sorted by hash or contains lines we do not
+        // understand; the sequential parser handles and reports those.
+        hibpFile.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+        return report(db, hibpFile, findings, error);
+    }
+
+    bool buildIndex(QIODevice& hibpInput, QIODevice& indexOutput, QString* error)
+    {
+        if (!hibpInput.isReadable()) {
+            *error = QObject::tr("Failed to read HIBP file: %1").arg(hibpInput.errorString());
+            return false;
+        }
+
+        QByteArray buckets(INDEX_RECORDS_OFFSET - INDEX_HEADER_SIZE, '\0');
+        auto* bucketData = reinterpret_cast<uchar*>(buckets.data());
+        if (!indexOutput.seek(0) || indexOutput.write(QByteArray(INDEX_RECORDS_OFFSET, '\0')) != INDEX_RECORDS_OFFSET) {
+            *error = QObject::tr("Failed to write HIBP index: %1").arg(indexOutput.errorString());
+            return false;
+        }
+
+        quint64 recordCount = 0;
+        int nextBucket = 0;
+        unsigned char previous[SHA1_BYTES];
+        unsigned char sha1[SHA1_BYTES];
+        uchar record[INDEX_RECORD_SIZE];
+        char line[128];
+
+        for (quint64 lineNum = 1;; ++lineNum) {
+            const qint64 length = hibpInput.readLine(line, sizeof(line));
+            if (length < 0 && !hibpInput.atEnd()) {
+                *error = QObject::tr("Failed to read HIBP file: %1").arg(hibpInput.errorString());
+                return false;
+            } else if (length <= 0) {
+                break;
+            }
+
+            // Lines consist of the hash, a colon and the count
+            qint64 end = length;
+            while (end > 0 && (line[end - 1] == '\n' || line[end - 1] == '\r')) {
+                --end;
+            }
+            if (end == 0) {
+                continue;
+            }
+
+            quint32 value = 0;
+            bool valid = end > static_cast<qint64>(SHA1_HEX_CHARS + 1) && decodeSha1Hex(line, sha1)
+                         && line[SHA1_HEX_CHARS] == ':';
+            for (qint64 i = SHA1_HEX_CHARS + 1; valid && i < end; ++i) {
+                const int digit = line[i] - '0';
+                valid = 0 <= digit && digit <= 9 && value <= (std::numeric_limits<quint32>::max() - digit) / 10;
+                value = value * 10 + digit;
+            }
+            if (!valid) {
+                *error = QObject::tr("HIBP file, line %1: parse error").arg(lineNum);
+                return false;
+            }
+
+            if (recordCount > 0 && std::memcmp(previous, sha1, SHA1_BYTES) >= 0) {
+                *error = QObject::tr("HIBP file, line %1: file is not sorted by hash").arg(lineNum);
+                return false;
+            }
+            std::memcpy(previous, sha1, SHA1_BYTES);
+
+            const int bucket = (sha1[0] << 8) | sha1[1];
+            for (; nextBucket <= bucket; ++nextBucket) {
+                qToLittleEndian<quint64>(recordCount, bucketData + nextBucket * INDEX_BUCKET_ENTRY_SIZE);
+            }
+
+            std::memcpy(record, sha1 + INDEX_PREFIX_BYTES, INDEX_HASH_SIZE);
+            qToLittleEndian<quint32>(value, record + INDEX_HASH_SIZE);
+            if (indexOutput.write(reinterpret_cast<const char*>(record), INDEX_RECORD_SIZE) != INDEX_RECORD_SIZE) {
+                *error = QObject::tr("Failed to write HIBP index: %1").arg(indexOutput.errorString());
+                return false;
+            }
+            ++recordCount;
+        }
+
+        // Close the remaining buckets, including the end marker
+        for (; nextBucket <= INDEX_BUCKETS; ++nextBucket) {
+            qToLittleEndian<quint64>(recordCount, bucketData + nextBucket * INDEX_BUCKET_ENTRY_SIZE);
+        }
+
+        QByteArray header(INDEX_HEADER_SIZE, '\0');
+        auto* headerData = reinterpret_cast<uchar*>(header.data());
+        std::memcpy(headerData, INDEX_MAGIC, INDEX_MAGIC_SIZE);
+        qToLittleEndian<quint32>(INDEX_VERSION, headerData + INDEX_MAGIC_SIZE);
+        qToLittleEndian<quint64>(recordCount, headerData + 16);
+
+        if (!indexOutput.seek(0) || indexOutput.write(header) != header.size()
+            || indexOutput.write(buckets) != buckets.size()) {
+            *error = QObject::tr("Failed to write HIBP index: %1").arg(indexOutput.errorString());
+            return false;
+        }
+
+        return true;
+    }
+
     bool okonReport(QSharedPointer<Database> db,
                     const QString& okon,
                     const QString& okonDatabase,
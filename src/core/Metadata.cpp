@@ -68,10 +68,15 @@ void Metadata::init()
 void Metadata::clear()
 {
     init();
+    const auto customIcons = m_customIconsOrder;
     m_customIcons.clear();
     m_customIconsOrder.clear();
     m_customIconsHashes.clear();
     m_customData->clear();
+
+    for (const QUuid& uuid : customIcons) {
+        emit customIconChanged(uuid);
+    }
 }
 
 template <class P, class V> bool Metadata::set(P& property, const V& value)
@@ -363,6 +368,7 @@ void Metadata::addCustomIcon(const QUuid& uuid, const CustomIconData& iconData)
     m_customIconsHashes[hash] = uuid;
     Q_ASSERT(m_customIcons.count() == m_customIconsOrder.count());
 
+    emit customIconChanged(uuid);
     emitModified();
 }
 
@@ -389,6 +395,7 @@ void Metadata::removeCustomIcon(const QUuid& uuid)
     m_customIconsOrder.removeAll(uuid);
     Q_ASSERT(m_customIcons.count() == m_customIconsOrder.count());
     dynamic_cast<Database*>(parent())->addDeletedObject(uuid);
+    emit customIconChanged(uuid);
     emitModified();
 }
 
@@ -160,6 +160,9 @@ public:
      */
     void copyAttributesFrom(const Metadata* other);
 
+signals:
+    void customIconChanged(const QUuid& uuid);
+
 private:
     template <class P, class V> bool set(P& property, const V& value);
     template <class P, class V> bool set(P& property, const V& value, QDateTime& dateTime);
@@ -49,10 +49,18 @@ bool ModifiableObject::modifiedSignalEnabled() const
     return true;
 }
 
+bool ModifiableObject::modifiedWhileBlocked() const
+{
+    return m_modifiedWhileBlocked;
+}
+
 void ModifiableObject::setEmitModified(bool value)
 {
     if (m_emitModified != value) {
         m_emitModified = value;
+        if (!value) {
+            m_modifiedWhileBlocked = false;
+        }
         emit emitModifiedChanged(m_emitModified);
     }
 }
@@ -61,5 +69,15 @@ void ModifiableObject::emitModified()
 {
     if (modifiedSignalEnabled()) {
         emit modified();
+        return;
+    }
+
+    // remember the change for every object blocking the signal
+    auto p = this;
+    while (p) {
+        if (!p->m_emitModified) {
+            p->m_modifiedWhileBlocked = true;
+        }
+        p = findParent<ModifiableObject*>(p);
     }
 }
@@ -34,6 +34,12 @@ public:
      */
     bool modifiedSignalEnabled() const;
 
+    /**
+     * @brief check if a modified signal of this object or one of its children was suppressed
+     * because this object disabled the signal. Cleared when the signal is disabled again.
+     */
+    bool modifiedWhileBlocked() const;
+
 public slots:
     /**
      * @brief set whether the modified signal should be emitted from this object and all its children.
@@ -54,6 +60,7 @@ signals:
 
 private:
     bool m_emitModified{true};
+    bool m_modifiedWhileBlocked{false};
 };
 
 #endif // KEEPASSXC_MODIFIABLEOBJECT_H
@@ -110,6 +110,12 @@ void PassphraseGenerator::setWordSeparator(const QString& separator)
 }
 
 QString PassphraseGenerator::generatePassphrase() const
+{
+    RandomBuffer random(m_wordCount * 8 + 64);
+    return generatePassphrase(random);
+}
+
+QString PassphraseGenerator::generatePassphrase(RandomBuffer& random) const
 {
     QString tmpWord;
     Q_ASSERT(isValid());
@@ -119,30 +125,61 @@ QString PassphraseGenerator::generatePassphrase() const
         return QString();
     }
 
+    const QVector<quint32> wordIndexes = random.randomUInts(static_cast<quint32>(m_wordlist.length()), m_wordCount);
+
     QStringList words;
-    for (int i = 0; i < m_wordCount; ++i) {
-        int wordIndex = randomGen()->randomUInt(static_cast<quint32>(m_wordlist.length()));
-        tmpWord = m_wordlist.at(wordIndex);
-
-        // convert case
-        switch (m_wordCase) {
-        case UPPERCASE:
-            tmpWord = tmpWord.toUpper();
-            break;
-        case TITLECASE:
-            tmpWord = tmpWord.replace(0, 1, tmpWord.left(1).toUpper());
-            break;
-        case LOWERCASE:
-        default:
-            tmpWord = tmpWord.toLower();
-            break;
-        }
-        words.append(tmpWord);
+    for (quint32 wordIndex : wordIndexes) {
+        tmpWord = m_wordlist.at(static_cast<int>(wordIndex));
+        words.append(convertCase(tmpWord));
     }
 
     return words.join(m_separator);
 }
 
+/**
+ * Generates @p count passphrases, the case of the word list is only
+ * converted once.
+ */
+QStringList PassphraseGenerator::generatePassphrases(int count, RandomBuffer& random) const
+{
+    Q_ASSERT(isValid());
+
+    QStringList passphrases;
+    if (m_wordlist.length() == 0) {
+        return passphrases;
+    }
+
+    QVector<QString> wordlist;
+    wordlist.reserve(m_wordlist.size());
+    for (const QString& word : m_wordlist) {
+        wordlist.append(convertCase(word));
+    }
+
+    passphrases.reserve(count);
+    QStringList words;
+    for (int i = 0; i < count; ++i) {
+        words.clear();
+        for (quint32 wordIndex : random.randomUInts(static_cast<quint32>(wordlist.length()), m_wordCount)) {
+            words.append(wordlist.at(static_cast<int>(wordIndex)));
+        }
+        passphrases.append(words.join(m_separator));
+    }
+    return passphrases;
+}
+
+QString PassphraseGenerator::convertCase(QString word) const
+{
+    switch (m_wordCase) {
+    case UPPERCASE:
+        return word.toUpper();
+    case TITLECASE:
+        return word.replace(0, 1, word.left(1).toUpper());
+    case LOWERCASE:
+    default:
+        return word.toLower();
+    }
+}
+
 bool PassphraseGenerator::isValid() const
 {
     if (m_wordCount == 0) {
@@ -18,8 +18,11 @@
 #ifndef KEEPASSX_PASSPHRASEGENERATOR_H
 #define KEEPASSX_PASSPHRASEGENERATOR_H
 
+#include <QStringList>
 #include <QVector>
 
+class RandomBuffer;
+
 class PassphraseGenerator
 {
 public:
@@ -42,12 +45,16 @@ public:
     bool isValid() const;
 
     QString generatePassphrase() const;
+    QString generatePassphrase(RandomBuffer& random) const;
+    QStringList generatePassphrases(int count, RandomBuffer& random) const;
 
     static constexpr int DefaultWordCount = 7;
     static const char* DefaultSeparator;
     static const char* DefaultWordList;
 
 private:
+    QString convertCase(QString word) const;
+
     int m_wordCount;
     PassphraseWordCase m_wordCase;
     QString m_separator;
@@ -58,36 +58,72 @@ void PasswordGenerator::setFlags(const GeneratorFlags& flags)
 }
 
 QString PasswordGenerator::generatePassword() const
+{
+    // Enough random numbers for the characters and the shuffle in one go
+    RandomBuffer random(m_length * 8 + 64);
+    return generatePassword(random);
+}
+
+QString PasswordGenerator::generatePassword(RandomBuffer& random) const
+{
+    Q_ASSERT(isValid());
+
+    const QVector<PasswordGroup> groups = passwordGroups();
+    return generatePassword(groups, passwordCharacters(groups), random);
+}
+
+/**
+ * Generates @p count passwords, the character pool is only built once.
+ */
+QStringList PasswordGenerator::generatePasswords(int count, RandomBuffer& random) const
 {
     Q_ASSERT(isValid());
 
     const QVector<PasswordGroup> groups = passwordGroups();
+    const QVector<QChar> passwordChars = passwordCharacters(groups);
+
+    QStringList passwords;
+    passwords.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        passwords.append(generatePassword(groups, passwordChars, random));
+    }
+    return passwords;
+}
 
+QVector<QChar> PasswordGenerator::passwordCharacters(const QVector<PasswordGroup>& groups) const
+{
     QVector<QChar> passwordChars;
     for (const PasswordGroup& group : groups) {
         for (QChar ch : group) {
             passwordChars.append(ch);
         }
     }
+    return passwordChars;
+}
 
+QString PasswordGenerator::generatePassword(const QVector<PasswordGroup>& groups,
+                                            const QVector<QChar>& passwordChars,
+                                            RandomBuffer& random) const
+{
     QString password;
+    password.reserve(m_length);
 
     if (m_flags & CharFromEveryGroup) {
         for (const auto& group : groups) {
-            int pos = randomGen()->randomUInt(static_cast<quint32>(group.size()));
+            int pos = random.randomUInt(static_cast<quint32>(group.size()));
 
             password.append(group[pos]);
         }
 
         for (int i = groups.size(); i < m_length; i++) {
-            int pos = randomGen()->randomUInt(static_cast<quint32>(passwordChars.size()));
+            int pos = random.randomUInt(static_cast<quint32>(passwordChars.size()));
 
             password.append(passwordChars[pos]);
         }
 
         // shuffle chars
         for (int i = (password.size() - 1); i >= 1; i--) {
-            int j = randomGen()->randomUInt(static_cast<quint32>(i + 1));
+            int j = random.randomUInt(static_cast<quint32>(i + 1));
 
             QChar tmp = password[i];
             password[i] = password[j];
@@ -95,7 +131,7 @@ QString PasswordGenerator::generatePassword() const
         }
     } else {
         for (int i = 0; i < m_length; i++) {
-            int pos = randomGen()->randomUInt(static_cast<quint32>(passwordChars.size()));
+            int pos = random.randomUInt(static_cast<quint32>(passwordChars.size()));
 
             password.append(passwordChars[pos]);
         }
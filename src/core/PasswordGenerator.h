@@ -20,8 +20,11 @@
 #define KEEPASSX_PASSWORDGENERATOR_H
 
 #include <QObject>
+#include <QStringList>
 #include <QVector>
 
+class RandomBuffer;
+
 typedef QVector<QChar> PasswordGroup;
 
 class PasswordGenerator
@@ -75,6 +78,8 @@ public:
     const QString& getExcludedCharacterSet() const;
 
     QString generatePassword() const;
+    QString generatePassword(RandomBuffer& random) const;
+    QStringList generatePasswords(int count, RandomBuffer& random) const;
 
     static const int DefaultLength;
     static const char* DefaultCustomCharacterSet;
@@ -82,6 +87,10 @@ public:
 
 private:
     QVector<PasswordGroup> passwordGroups() const;
+    QVector<QChar> passwordCharacters(const QVector<PasswordGroup>& groups) const;
+    QString generatePassword(const QVector<PasswordGroup>& groups,
+                             const QVector<QChar>& passwordChars,
+                             RandomBuffer& random) const;
     int numCharClasses() const;
 
     int m_length;
@@ -0,0 +1,151 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AesKdfKernel.h"
+
+#include <botan/cpuid.h>
+#include <botan/mem_ops.h>
+
+#if defined(BOTAN_TARGET_CPU_IS_X86_FAMILY)
+#define WITH_AESNI_KERNEL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AESNI_FUNCTION __attribute__((target("sse2,aes")))
+#else
+#define AESNI_FUNCTION
+#endif
+#endif
+
+#ifdef WITH_AESNI_KERNEL
+namespace
+{
+    AESNI_FUNCTION inline __m128i expandEvenKey(__m128i key, __m128i assist)
+    {
+        assist = _mm_shuffle_epi32(assist, 0xff);
+        __m128i shifted = _mm_slli_si128(key, 4);
+        key = _mm_xor_si128(key, shifted);
+        shifted = _mm_slli_si128(shifted, 4);
+        key = _mm_xor_si128(key, shifted);
+        shifted = _mm_slli_si128(shifted, 4);
+        key = _mm_xor_si128(key, shifted);
+        return _mm_xor_si128(key, assist);
+    }
+
+    AESNI_FUNCTION inline __m128i expandOddKey(__m128i evenKey, __m128i key)
+    {
+        const __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(evenKey, 0x00), 0xaa);
+        __m128i shifted = _mm_slli_si128(key, 4);
+        key = _mm_xor_si128(key, shifted);
+        shifted = _mm_slli_si128(shifted, 4);
+        key = _mm_xor_si128(key, shifted);
+        shifted = _mm_slli_si128(shifted, 4);
+        key = _mm_xor_si128(key, shifted);
+        return _mm_xor_si128(key, assist);
+    }
+
+    // _mm_aeskeygenassist_si128 needs the round constant as immediate
+#define EXPAND_KEY_PAIR(i, rcon)                                                                                       \
+    k[i] = expandEvenKey(k[i - 2], _mm_aeskeygenassist_si128(k[i - 1], rcon));                                        \
+    k[i + 1] = expandOddKey(k[i], k[i - 1])
+
+    AESNI_FUNCTION void expandKey(const quint8* key, __m128i* k)
+    {
+        k[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+        k[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+        EXPAND_KEY_PAIR(2, 0x01);
+        EXPAND_KEY_PAIR(4, 0x02);
+        EXPAND_KEY_PAIR(6, 0x04);
+        EXPAND_KEY_PAIR(8, 0x08);
+        EXPAND_KEY_PAIR(10, 0x10);
+        EXPAND_KEY_PAIR(12, 0x20);
+        k[14] = expandEvenKey(k[12], _mm_aeskeygenassist_si128(k[13], 0x40));
+    }
+
+#undef EXPAND_KEY_PAIR
+
+    AESNI_FUNCTION void transformAesNi(const quint8* key, int rounds, quint8* data, int blocks)
+    {
+        __m128i k[15];
+        expandKey(key, k);
+
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        __m128i b1 = blocks > 1 ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)) : _mm_setzero_si128();
+
+#define AES_ROUND(r)                                                                                                   \
+    b0 = _mm_aesenc_si128(b0, k[r]);                                                                                   \
+    b1 = _mm_aesenc_si128(b1, k[r])
+
+        // The second block is always encrypted, its result is only stored if it is used
+        for (int i = 0; i < rounds; ++i) {
+            b0 = _mm_xor_si128(b0, k[0]);
+            b1 = _mm_xor_si128(b1, k[0]);
+            AES_ROUND(1);
+            AES_ROUND(2);
+            AES_ROUND(3);
+            AES_ROUND(4);
+            AES_ROUND(5);
+            AES_ROUND(6);
+            AES_ROUND(7);
+            AES_ROUND(8);
+            AES_ROUND(9);
+            AES_ROUND(10);
+            AES_ROUND(11);
+            AES_ROUND(12);
+            AES_ROUND(13);
+            b0 = _mm_aesenclast_si128(b0, k[14]);
+            b1 = _mm_aesenclast_si128(b1, k[14]);
+        }
+
+#undef AES_ROUND
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data), b0);
+        if (blocks > 1) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + 16), b1);
+        }
+
+        Botan::secure_scrub_memory(k, sizeof(k));
+    }
+} // namespace
+#endif
+
+namespace AesKdfKernel
+{
+    bool isSupported()
+    {
+#ifdef WITH_AESNI_KERNEL
+        return Botan::CPUID::has_aes_ni();
+#else
+        return false;
+#endif
+    }
+
+    void transform(const quint8* key, int rounds, quint8* data, int blocks)
+    {
+        Q_ASSERT(isSupported());
+        Q_ASSERT(blocks == 1 || blocks == 2);
+#ifdef WITH_AESNI_KERNEL
+        transformAesNi(key, rounds, data, blocks);
+#else
+        Q_UNUSED(key);
+        Q_UNUSED(rounds);
+        Q_UNUSED(data);
+        Q_UNUSED(blocks);
+#endif
+    }
+} // namespace AesKdfKernel
@@ -0,0 +1,39 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_AESKDFKERNEL_H
+#define KEEPASSXC_AESKDFKERNEL_H
+
+#include <QtGlobal>
+
+/**
+ * AES-256 ECB round loop of the AES-KDF using AES-NI. The key schedule is
+ * kept in registers for all rounds and the two blocks of the transformed
+ * key are encrypted interleaved, so their latencies overlap.
+ */
+namespace AesKdfKernel
+{
+    bool isSupported();
+
+    /**
+     * Encrypts one or two 16 byte blocks @p rounds times in place.
+     * Only valid if isSupported() returns true.
+     */
+    void transform(const quint8* key, int rounds, quint8* data, int blocks);
+} // namespace AesKdfKernel
+
+#endif // KEEPASSXC_AESKDFKERNEL_H
@@ -21,8 +21,23 @@
 
 #include <QSharedPointer>
 
+#include <botan/mem_ops.h>
 #include <botan/system_rng.h>
 
+#include <cstring>
+
+namespace
+{
+    /**
+     * Largest random number that can be used without modulo bias
+     * for the range [0, limit)
+     */
+    quint32 unbiasedCeil(quint32 limit)
+    {
+        return QUINT32_MAX - (QUINT32_MAX % limit) - 1;
+    }
+} // namespace
+
 QSharedPointer<Random> Random::m_instance;
 
 QSharedPointer<Random> Random::instance()
@@ -67,7 +82,7 @@ quint32 Random::randomUInt(quint32 limit)
     }
 
     quint32 rand;
-    const quint32 ceil = QUINT32_MAX - (QUINT32_MAX % limit) - 1;
+    const quint32 ceil = unbiasedCeil(limit);
 
     // To avoid modulo bias make sure rand is below the largest number where rand%limit==0
     do {
@@ -81,3 +96,56 @@ quint32 Random::randomUIntRange(quint32 min, quint32 max)
 {
     return min + randomUInt(max - min);
 }
+
+const int RandomBuffer::DefaultBufferSize = 4096;
+
+RandomBuffer::RandomBuffer(int bufferSize)
+    : m_buffer(static_cast<size_t>(qMax(bufferSize, 4) & ~3))
+    , m_pos(m_buffer.size())
+{
+}
+
+quint32 RandomBuffer::randomUInt(quint32 limit)
+{
+    if (limit == 0) {
+        return 0;
+    }
+
+    quint32 rand;
+    const quint32 ceil = unbiasedCeil(limit);
+
+    do {
+        rand = nextUInt();
+    } while (rand > ceil);
+
+    return (rand % limit);
+}
+
+QVector<quint32> RandomBuffer::randomUInts(quint32 limit, int count)
+{
+    QVector<quint32> values;
+    values.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        values.append(randomUInt(limit));
+    }
+    return values;
+}
+
+quint32 RandomBuffer::nextUInt()
+{
+    if (m_pos + 4 > static_cast<int>(m_buffer.size())) {
+        refill();
+    }
+
+    quint32 rand;
+    std::memcpy(&rand, m_buffer.data() + m_pos, 4);
+    Botan::secure_scrub_memory(m_buffer.data() + m_pos, 4);
+    m_pos += 4;
+    return rand;
+}
+
+void RandomBuffer::refill()
+{
+    randomGen()->getRng()->randomize(m_buffer.data(), m_buffer.size());
+    m_pos = 0;
+}
@@ -19,8 +19,10 @@
 #define KEEPASSX_RANDOM_H
 
 #include <QSharedPointer>
+#include <QVector>
 
 #include <botan/rng.h>
+#include <botan/secmem.h>
 
 class Random
 {
@@ -50,6 +52,41 @@ private:
     QSharedPointer<Botan::RandomNumberGenerator> m_rng;
 };
 
+/**
+ * Draws random numbers from a buffer that is refilled from the system
+ * RNG in blocks of @p bufferSize bytes, instead of requesting 4 bytes
+ * per number. The bytes of a number are wiped from the buffer as soon as
+ * it is drawn, unused bytes when the buffer is destroyed.
+ *
+ * Not thread safe, use one instance per thread.
+ */
+class RandomBuffer
+{
+public:
+    static const int DefaultBufferSize;
+
+    explicit RandomBuffer(int bufferSize = DefaultBufferSize);
+
+    /**
+     * Generate a random quint32 in the range [0, @p limit)
+     */
+    quint32 randomUInt(quint32 limit);
+
+    /**
+     * Generate @p count random quint32 in the range [0, @p limit)
+     */
+    QVector<quint32> randomUInts(quint32 limit, int count);
+
+private:
+    Q_DISABLE_COPY(RandomBuffer);
+
+    quint32 nextUInt();
+    void refill();
+
+    Botan::secure_vector<uint8_t> m_buffer;
+    int m_pos;
+};
+
 static inline QSharedPointer<Random> randomGen()
 {
     return Random::instance();
@@ -18,13 +18,19 @@
 #include "SymmetricCipher.h"
 
 #include "config-keepassx.h"
+#include "crypto/AesKdfKernel.h"
 #include "format/KeePass2.h"
 
 #include <botan/block_cipher.h>
 #include <botan/cipher_mode.h>
+#include <botan/stream_cipher.h>
 
 bool SymmetricCipher::init(Mode mode, Direction direction, const QByteArray& key, const QByteArray& iv)
 {
+    // Drop the cipher of a previous initialization, process() uses whichever one is set
+    m_cipher.reset();
+    m_streamCipher.reset();
+
     m_mode = mode;
     if (mode == InvalidMode) {
         m_error = QObject::tr("SymmetricCipher::init: Invalid cipher mode.");
@@ -35,6 +41,23 @@ bool SymmetricCipher::init(Mode mode, Direction direction, const QByteArray& key
         auto botanMode = modeToString(mode);
         auto botanDirection = (direction == SymmetricCipher::Encrypt ? Botan::ENCRYPTION : Botan::DECRYPTION);
 
+        if (blockSize(mode) == 1) {
+            // Stream ciphers are used without the Cipher_Mode wrapper so that they can seek
+            auto cipher = Botan::StreamCipher::create_or_throw(botanMode.toStdString());
+            m_streamCipher.reset(cipher.release());
+            m_streamCipher->set_key(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+
+            if (!m_streamCipher->valid_iv_length(iv.size())) {
+                m_mode = InvalidMode;
+                m_streamCipher.reset();
+                m_error =
+                    QObject::tr("SymmetricCipher::init: Invalid IV size of %1 for %2.").arg(iv.size()).arg(botanMode);
+                return false;
+            }
+            m_streamCipher->set_iv(reinterpret_cast<const uint8_t*>(iv.data()), iv.size());
+            return true;
+        }
+
         auto cipher = Botan::Cipher_Mode::create_or_throw(botanMode.toStdString(), botanDirection);
         m_cipher.reset(cipher.release());
         m_cipher->set_key(reinterpret_cast<const uint8_t*>(key.data()), key.size());
@@ -49,6 +72,7 @@ bool SymmetricCipher::init(Mode mode, Direction direction, const QByteArray& key
     } catch (std::exception& e) {
         m_mode = InvalidMode;
         m_cipher.reset();
+        m_streamCipher.reset();
 
         m_error = e.what();
         reset();
@@ -60,7 +84,7 @@ bool SymmetricCipher::init(Mode mode, Direction direction, const QByteArray& key
 
 bool SymmetricCipher::isInitalized() const
 {
-    return m_cipher;
+    return m_cipher || m_streamCipher;
 }
 
 bool SymmetricCipher::process(char* data, int len)
@@ -76,6 +100,10 @@ bool SymmetricCipher::process(char* data, int len)
     }
 
     try {
+        if (m_streamCipher) {
+            m_streamCipher->cipher1(reinterpret_cast<uint8_t*>(data), len);
+            return true;
+        }
         // Block size is checked by Botan, an exception is thrown if invalid
         m_cipher->process(reinterpret_cast<uint8_t*>(data), len);
         return true;
@@ -99,6 +127,11 @@ bool SymmetricCipher::finish(QByteArray& data)
     }
 
     try {
+        if (m_streamCipher) {
+            // Stream ciphers have no padding, the data is processed as is
+            m_streamCipher->cipher1(reinterpret_cast<uint8_t*>(data.data()), data.size());
+            return true;
+        }
         // Error checking is done by Botan, an exception is thrown if invalid
         Botan::secure_vector<uint8_t> input(data.begin(), data.end());
         m_cipher->finish(input);
@@ -113,11 +146,33 @@ bool SymmetricCipher::finish(QByteArray& data)
     }
 }
 
+/**
+ * Moves a stream cipher to the given byte offset of its key stream,
+ * so data can be processed out of order. Block cipher modes cannot seek.
+ */
+bool SymmetricCipher::seek(quint64 offset)
+{
+    Q_ASSERT(isInitalized());
+    if (!m_streamCipher) {
+        m_error = QObject::tr("Cipher mode does not support seeking.");
+        return false;
+    }
+
+    try {
+        m_streamCipher->seek(offset);
+        return true;
+    } catch (std::exception& e) {
+        m_error = e.what();
+        return false;
+    }
+}
+
 void SymmetricCipher::reset()
 {
     m_error.clear();
     if (isInitalized()) {
         m_cipher.reset();
+        m_streamCipher.reset();
     }
 }
 
@@ -128,6 +183,14 @@ SymmetricCipher::Mode SymmetricCipher::mode()
 
 bool SymmetricCipher::aesKdf(const QByteArray& key, int rounds, QByteArray& data)
 {
+    if (key.size() == 32 && (data.size() == 16 || data.size() == 32) && AesKdfKernel::isSupported()) {
+        AesKdfKernel::transform(reinterpret_cast<const quint8*>(key.constData()),
+                                rounds,
+                                reinterpret_cast<quint8*>(data.data()),
+                                data.size() / 16);
+        return true;
+    }
+
     try {
         std::unique_ptr<Botan::BlockCipher> cipher(Botan::BlockCipher::create("AES-256"));
         cipher->set_key(reinterpret_cast<const uint8_t*>(key.data()), key.size());
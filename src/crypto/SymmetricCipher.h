@@ -25,6 +25,7 @@
 namespace Botan
 {
     class Cipher_Mode;
+    class StreamCipher;
 }
 
 class SymmetricCipher
@@ -57,6 +58,7 @@ public:
     Q_REQUIRED_RESULT bool process(char* data, int len);
     Q_REQUIRED_RESULT bool process(QByteArray& data);
     Q_REQUIRED_RESULT bool finish(QByteArray& data);
+    Q_REQUIRED_RESULT bool seek(quint64 offset);
 
     static bool aesKdf(const QByteArray& key, int rounds, QByteArray& data);
 
@@ -77,6 +79,7 @@ private:
     QString m_error;
     Mode m_mode;
     QSharedPointer<Botan::Cipher_Mode> m_cipher;
+    QSharedPointer<Botan::StreamCipher> m_streamCipher;
 
     Q_DISABLE_COPY(SymmetricCipher)
 };
@@ -22,8 +22,22 @@
 
 #include <argon2.h>
 
+#include "core/Global.h"
+#include "crypto/kdf/Argon2Parallel.h"
 #include "format/KeePass2.h"
 
+namespace
+{
+    // Memory used to measure the throughput of each degree of parallelism, in KiB
+    const quint64 ProbeMemory = 1 << 15;
+
+    // Whole MiB as shown in the database settings
+    quint64 roundedMemory(quint64 kibibytes)
+    {
+        return kibibytes >= (1 << 10) ? kibibytes & ~static_cast<quint64>((1 << 10) - 1) : kibibytes;
+    }
+} // namespace
+
 /**
  * KeePass' Argon2 implementation supports all parameters that are defined in the official specification,
  * but only the number of iterations, the memory size and the degree of parallelism can be configured by
@@ -165,8 +179,18 @@ bool Argon2Kdf::transform(const QByteArray& raw, QByteArray& result) const
 {
     result.clear();
     result.resize(32);
-    // Time Cost, Mem Cost, Threads/Lanes, Password, length, Salt, length, out, length
 
+    if (parallelism() > 1) {
+        // Run the lanes on our own thread pool, libargon2 may have been built without thread support
+        auto argon2Type = type() == Type::Argon2d ? Argon2Parallel::Type::Argon2d : Argon2Parallel::Type::Argon2id;
+        if (!Argon2Parallel::hash(argon2Type, version(), rounds(), memory(), parallelism(), raw, seed(), result)) {
+            qWarning("Argon2 error: invalid parameters");
+            return false;
+        }
+        return true;
+    }
+
+    // Time Cost, Mem Cost, Threads/Lanes, Password, length, Salt, length, out, length
     int rc = argon2_hash(rounds(),
                          memory(),
                          parallelism(),
@@ -207,6 +231,80 @@ int Argon2Kdf::benchmark(int msec) const
     return 1;
 }
 
+/**
+ * Searches the degree of parallelism, the memory size and the number of
+ * iterations for the strongest parameters that transform a key in about
+ * msec on this machine.
+ *
+ * The throughput of every sensible number of lanes is measured first, the
+ * resulting budget is then spent on memory before iterations since memory
+ * is what makes Argon2 expensive to attack. The parameters are verified
+ * with a full transformation and scaled down if they overshoot.
+ *
+ * @param msec target transformation time
+ * @param maxMemory upper bound for the memory size, in KiB
+ * @return false if the key could not be transformed
+ */
+bool Argon2Kdf::calibrate(int msec, quint64 maxMemory)
+{
+    QByteArray key = QByteArray(16, '\x7E');
+    QByteArray result;
+    const auto idealThreads = static_cast<quint32>(qMax(1, QThread::idealThreadCount()));
+
+    QList<quint32> candidates;
+    for (quint32 lanes = 1; lanes < idealThreads; lanes *= 2) {
+        candidates.append(lanes);
+    }
+    candidates.append(idealThreads);
+
+    Argon2Kdf probe(*this);
+    probe.setRounds(1);
+
+    quint32 bestLanes = 1;
+    double bestThroughput = 0;
+    for (quint32 lanes : asConst(candidates)) {
+        probe.setParallelism(lanes);
+        probe.setMemory(qMax<quint64>(qMin(ProbeMemory, maxMemory), 8 * lanes));
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!probe.transform(key, result)) {
+            return false;
+        }
+        // KiB per millisecond for a single iteration
+        double throughput = static_cast<double>(probe.memory()) / qMax<qint64>(1, timer.elapsed());
+        if (throughput > bestThroughput) {
+            bestThroughput = throughput;
+            bestLanes = lanes;
+        }
+    }
+
+    setParallelism(bestLanes);
+    const quint64 minMemory = 8 * bestLanes;
+    const auto budget = static_cast<quint64>(bestThroughput * msec);
+    setMemory(roundedMemory(qBound(minMemory, budget / MIN_CALIBRATION_ROUNDS, qMax(minMemory, maxMemory))));
+    setRounds(static_cast<int>(qMax<quint64>(MIN_CALIBRATION_ROUNDS, budget / memory())));
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!transform(key, result)) {
+        return false;
+    }
+
+    // Larger memory sizes are slower per block, spend proportionally less if the target was missed
+    const qint64 elapsed = timer.elapsed();
+    if (elapsed > msec + msec / 10) {
+        const double scale = static_cast<double>(msec) / elapsed;
+        if (rounds() > MIN_CALIBRATION_ROUNDS) {
+            setRounds(qMax(MIN_CALIBRATION_ROUNDS, static_cast<int>(rounds() * scale)));
+        } else {
+            setMemory(roundedMemory(qMax(minMemory, static_cast<quint64>(memory() * scale))));
+        }
+    }
+
+    return true;
+}
+
 QString Argon2Kdf::toString() const
 {
     return QObject::tr("Argon2%1 (%2 rounds, %3 KB)")
@@ -46,6 +46,16 @@ public:
     QString toString() const override;
 
     int benchmark(int msec) const override;
+    bool calibrate(int msec, quint64 maxMemory = DEFAULT_CALIBRATION_MEMORY);
+
+    /*
+     * Default upper bound of the memory chosen by calibrate(), in KiB.
+     */
+    static constexpr quint64 DEFAULT_CALIBRATION_MEMORY = 1 << 18;
+    /*
+     * Minimum number of iterations chosen by calibrate().
+     */
+    static constexpr int MIN_CALIBRATION_ROUNDS = 2;
 
     quint32 m_version;
     quint64 m_memory;
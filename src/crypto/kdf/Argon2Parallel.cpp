@@ -0,0 +1,429 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Argon2Parallel.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <botan/hash.h>
+#include <botan/mem_ops.h>
+#include <botan/secmem.h>
+
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    const int BlockSize = 1024;
+    const int QWordsInBlock = BlockSize / 8;
+    const quint32 SyncPoints = 4;
+    const int PrehashSize = 64;
+    const int TagSize = 32;
+
+    struct Block
+    {
+        quint64 v[QWordsInBlock];
+    };
+
+    struct Instance
+    {
+        Argon2Parallel::Type type;
+        quint32 version;
+        quint32 passes;
+        quint32 lanes;
+        quint32 memoryBlocks;
+        quint32 segmentLength;
+        quint32 laneLength;
+        Block* memory;
+    };
+
+    struct Position
+    {
+        quint32 pass;
+        quint32 lane;
+        quint32 slice;
+        quint32 index;
+    };
+
+    inline quint64 rotr64(quint64 w, unsigned c)
+    {
+        return (w >> c) | (w << (64 - c));
+    }
+
+    inline quint64 blaMka(quint64 x, quint64 y)
+    {
+        const quint64 m = 0xFFFFFFFFULL;
+        return x + y + 2 * ((x & m) * (y & m));
+    }
+
+    inline void g(quint64& a, quint64& b, quint64& c, quint64& d)
+    {
+        a = blaMka(a, b);
+        d = rotr64(d ^ a, 32);
+        c = blaMka(c, d);
+        b = rotr64(b ^ c, 24);
+        a = blaMka(a, b);
+        d = rotr64(d ^ a, 16);
+        c = blaMka(c, d);
+        b = rotr64(b ^ c, 63);
+    }
+
+    /**
+     * Blake2b round without message on 16 words of a block. The words are
+     * taken pairwise, pairStride apart, which gives the columns with a
+     * stride of 2 and the rows with a stride of 16.
+     */
+    inline void blake2Round(quint64* v, int first, int pairStride)
+    {
+        quint64* w[16];
+        for (int k = 0; k < 16; ++k) {
+            w[k] = &v[first + (k / 2) * pairStride + k % 2];
+        }
+
+        g(*w[0], *w[4], *w[8], *w[12]);
+        g(*w[1], *w[5], *w[9], *w[13]);
+        g(*w[2], *w[6], *w[10], *w[14]);
+        g(*w[3], *w[7], *w[11], *w[15]);
+        g(*w[0], *w[5], *w[10], *w[15]);
+        g(*w[1], *w[6], *w[11], *w[12]);
+        g(*w[2], *w[7], *w[8], *w[13]);
+        g(*w[3], *w[4], *w[9], *w[14]);
+    }
+
+    /**
+     * Compression function G of Argon2: next = P(prev ^ ref) ^ prev ^ ref,
+     * additionally XORed with the old content of next when withXor is set.
+     */
+    void fillBlock(const Block& prev, const Block& ref, Block& next, bool withXor)
+    {
+        Block r;
+        Block tmp;
+        for (int i = 0; i < QWordsInBlock; ++i) {
+            r.v[i] = prev.v[i] ^ ref.v[i];
+        }
+        tmp = r;
+        if (withXor) {
+            for (int i = 0; i < QWordsInBlock; ++i) {
+                tmp.v[i] ^= next.v[i];
+            }
+        }
+
+        for (int i = 0; i < 8; ++i) {
+            blake2Round(r.v, 16 * i, 2);
+        }
+        for (int i = 0; i < 8; ++i) {
+            blake2Round(r.v, 2 * i, 16);
+        }
+
+        for (int i = 0; i < QWordsInBlock; ++i) {
+            next.v[i] = tmp.v[i] ^ r.v[i];
+        }
+
+        Botan::secure_scrub_memory(&r, sizeof(r));
+        Botan::secure_scrub_memory(&tmp, sizeof(tmp));
+    }
+
+    void appendLE32(std::unique_ptr<Botan::HashFunction>& hash, quint32 value)
+    {
+        quint8 bytes[4];
+        qToLittleEndian(value, bytes);
+        hash->update(bytes, sizeof(bytes));
+    }
+
+    /**
+     * Variable length hash H' built on Blake2b, used for the first blocks
+     * of every lane and for the final tag.
+     */
+    void blake2bLong(const quint8* in, size_t inLength, quint8* out, quint32 outLength)
+    {
+        if (outLength <= 64) {
+            auto hash = Botan::HashFunction::create_or_throw(QString("BLAKE2b(%1)").arg(outLength * 8).toStdString());
+            appendLE32(hash, outLength);
+            hash->update(in, inLength);
+            hash->final(out);
+            return;
+        }
+
+        auto hash = Botan::HashFunction::create_or_throw("BLAKE2b(512)");
+        quint8 v[64];
+        appendLE32(hash, outLength);
+        hash->update(in, inLength);
+        hash->final(v);
+        std::memcpy(out, v, 32);
+        out += 32;
+        quint32 remaining = outLength - 32;
+
+        while (remaining > 64) {
+            hash->update(v, sizeof(v));
+            hash->final(v);
+            std::memcpy(out, v, 32);
+            out += 32;
+            remaining -= 32;
+        }
+
+        auto last = Botan::HashFunction::create_or_throw(QString("BLAKE2b(%1)").arg(remaining * 8).toStdString());
+        last->update(v, sizeof(v));
+        last->final(out);
+        Botan::secure_scrub_memory(v, sizeof(v));
+    }
+
+    void loadBlock(Block& block, const quint8* bytes)
+    {
+        for (int i = 0; i < QWordsInBlock; ++i) {
+            block.v[i] = qFromLittleEndian<quint64>(bytes + 8 * i);
+        }
+    }
+
+    void storeBlock(quint8* bytes, const Block& block)
+    {
+        for (int i = 0; i < QWordsInBlock; ++i) {
+            qToLittleEndian(block.v[i], bytes + 8 * i);
+        }
+    }
+
+    void initialHash(const Instance& instance,
+                     quint32 memory,
+                     const QByteArray& password,
+                     const QByteArray& salt,
+                     quint8* prehash)
+    {
+        auto hash = Botan::HashFunction::create_or_throw("BLAKE2b(512)");
+        appendLE32(hash, instance.lanes);
+        appendLE32(hash, TagSize);
+        appendLE32(hash, memory);
+        appendLE32(hash, instance.passes);
+        appendLE32(hash, instance.version);
+        appendLE32(hash, static_cast<quint32>(instance.type));
+        appendLE32(hash, static_cast<quint32>(password.size()));
+        hash->update(reinterpret_cast<const quint8*>(password.constData()), password.size());
+        appendLE32(hash, static_cast<quint32>(salt.size()));
+        hash->update(reinterpret_cast<const quint8*>(salt.constData()), salt.size());
+        // No secret and no associated data
+        appendLE32(hash, 0);
+        appendLE32(hash, 0);
+        hash->final(prehash);
+    }
+
+    void fillFirstBlocks(const Instance& instance, quint8* prehash)
+    {
+        quint8 bytes[BlockSize];
+        for (quint32 lane = 0; lane < instance.lanes; ++lane) {
+            qToLittleEndian(lane, prehash + PrehashSize + 4);
+            for (quint32 i = 0; i < 2; ++i) {
+                qToLittleEndian(i, prehash + PrehashSize);
+                blake2bLong(prehash, PrehashSize + 8, bytes, BlockSize);
+                loadBlock(instance.memory[lane * instance.laneLength + i], bytes);
+            }
+        }
+        Botan::secure_scrub_memory(bytes, sizeof(bytes));
+    }
+
+    quint32 indexAlpha(const Instance& instance, const Position& position, quint32 pseudoRand, bool sameLane)
+    {
+        quint32 referenceAreaSize;
+        if (position.pass == 0) {
+            if (position.slice == 0) {
+                referenceAreaSize = position.index - 1;
+            } else if (sameLane) {
+                referenceAreaSize = position.slice * instance.segmentLength + position.index - 1;
+            } else {
+                referenceAreaSize = position.slice * instance.segmentLength + (position.index == 0 ? -1 : 0);
+            }
+        } else {
+            if (sameLane) {
+                referenceAreaSize = instance.laneLength - instance.segmentLength + position.index - 1;
+            } else {
+                referenceAreaSize = instance.laneLength - instance.segmentLength + (position.index == 0 ? -1 : 0);
+            }
+        }
+
+        quint64 relativePosition = pseudoRand;
+        relativePosition = relativePosition * relativePosition >> 32;
+        relativePosition = referenceAreaSize - 1 - (referenceAreaSize * relativePosition >> 32);
+
+        quint32 startPosition = 0;
+        if (position.pass != 0 && position.slice != SyncPoints - 1) {
+            startPosition = (position.slice + 1) * instance.segmentLength;
+        }
+
+        return static_cast<quint32>((startPosition + relativePosition) % instance.laneLength);
+    }
+
+    void nextAddresses(Block& addressBlock, Block& inputBlock, const Block& zeroBlock)
+    {
+        inputBlock.v[6]++;
+        fillBlock(zeroBlock, inputBlock, addressBlock, false);
+        fillBlock(zeroBlock, addressBlock, addressBlock, false);
+    }
+
+    void fillSegment(const Instance& instance, Position position)
+    {
+        using Argon2Parallel::Type;
+        const bool independentAddressing =
+            instance.type == Type::Argon2i
+            || (instance.type == Type::Argon2id && position.pass == 0 && position.slice < SyncPoints / 2);
+
+        Block addressBlock = {};
+        Block inputBlock = {};
+        const Block zeroBlock = {};
+        if (independentAddressing) {
+            inputBlock.v[0] = position.pass;
+            inputBlock.v[1] = position.lane;
+            inputBlock.v[2] = position.slice;
+            inputBlock.v[3] = instance.memoryBlocks;
+            inputBlock.v[4] = instance.passes;
+            inputBlock.v[5] = static_cast<quint64>(instance.type);
+        }
+
+        quint32 startingIndex = 0;
+        if (position.pass == 0 && position.slice == 0) {
+            // The first two blocks of each lane are already filled
+            startingIndex = 2;
+            if (independentAddressing) {
+                nextAddresses(addressBlock, inputBlock, zeroBlock);
+            }
+        }
+
+        quint32 currOffset =
+            position.lane * instance.laneLength + position.slice * instance.segmentLength + startingIndex;
+        quint32 prevOffset = currOffset - 1;
+        if (currOffset % instance.laneLength == 0) {
+            prevOffset = currOffset + instance.laneLength - 1;
+        }
+
+        for (quint32 i = startingIndex; i < instance.segmentLength; ++i, ++currOffset, ++prevOffset) {
+            if (currOffset % instance.laneLength == 1) {
+                prevOffset = currOffset - 1;
+            }
+
+            quint64 pseudoRand;
+            if (independentAddressing) {
+                if (i % QWordsInBlock == 0) {
+                    nextAddresses(addressBlock, inputBlock, zeroBlock);
+                }
+                pseudoRand = addressBlock.v[i % QWordsInBlock];
+            } else {
+                pseudoRand = instance.memory[prevOffset].v[0];
+            }
+
+            quint32 refLane = static_cast<quint32>((pseudoRand >> 32) % instance.lanes);
+            if (position.pass == 0 && position.slice == 0) {
+                refLane = position.lane;
+            }
+
+            position.index = i;
+            const quint32 refIndex =
+                indexAlpha(instance, position, static_cast<quint32>(pseudoRand), refLane == position.lane);
+
+            const Block& refBlock = instance.memory[instance.laneLength * refLane + refIndex];
+            const bool withXor = instance.version != 0x10 && position.pass != 0;
+            fillBlock(instance.memory[prevOffset], refBlock, instance.memory[currOffset], withXor);
+        }
+
+        Botan::secure_scrub_memory(&addressBlock, sizeof(addressBlock));
+    }
+} // namespace
+
+namespace Argon2Parallel
+{
+    /**
+     * Computes a 32 byte Argon2 tag. The lanes of a segment only reference
+     * blocks of finished segments, so they are filled concurrently with a
+     * barrier between the four slices of every pass.
+     *
+     * @param memory memory cost in KiB
+     * @param lanes degree of parallelism, also the upper bound of threads used
+     * @return false if the parameters are invalid
+     */
+    bool hash(Type type,
+              quint32 version,
+              quint32 iterations,
+              quint32 memory,
+              quint32 lanes,
+              const QByteArray& password,
+              const QByteArray& salt,
+              QByteArray& result)
+    {
+        if ((version != 0x10 && version != 0x13) || iterations < 1 || lanes < 1 || lanes >= (1 << 24)
+            || memory < 8 * lanes || salt.size() < 8) {
+            return false;
+        }
+
+        Instance instance;
+        instance.type = type;
+        instance.version = version;
+        instance.passes = iterations;
+        instance.lanes = lanes;
+        instance.segmentLength = memory / (lanes * SyncPoints);
+        instance.laneLength = instance.segmentLength * SyncPoints;
+        instance.memoryBlocks = instance.laneLength * lanes;
+
+        try {
+            Botan::secure_vector<Block> blocks(instance.memoryBlocks);
+            instance.memory = blocks.data();
+
+            Botan::secure_vector<quint8> prehash(PrehashSize + 8);
+            initialHash(instance, memory, password, salt, prehash.data());
+            fillFirstBlocks(instance, prehash.data());
+
+            QThreadPool pool;
+            pool.setMaxThreadCount(qMin(static_cast<int>(lanes), QThread::idealThreadCount()));
+            QVector<QFuture<void>> futures;
+            futures.reserve(static_cast<int>(lanes));
+
+            for (quint32 pass = 0; pass < instance.passes; ++pass) {
+                for (quint32 slice = 0; slice < SyncPoints; ++slice) {
+                    if (lanes == 1) {
+                        fillSegment(instance, {pass, 0, slice, 0});
+                        continue;
+                    }
+
+                    futures.clear();
+                    for (quint32 lane = 0; lane < lanes; ++lane) {
+                        futures.append(QtConcurrent::run(&pool, fillSegment, instance, Position{pass, lane, slice, 0}));
+                    }
+                    for (auto& future : futures) {
+                        future.waitForFinished();
+                    }
+                }
+            }
+
+            Block finalBlock = instance.memory[instance.laneLength - 1];
+            for (quint32 lane = 1; lane < lanes; ++lane) {
+                const Block& lastBlock = instance.memory[lane * instance.laneLength + instance.laneLength - 1];
+                for (int i = 0; i < QWordsInBlock; ++i) {
+                    finalBlock.v[i] ^= lastBlock.v[i];
+                }
+            }
+
+            Botan::secure_vector<quint8> finalBytes(BlockSize);
+            storeBlock(finalBytes.data(), finalBlock);
+            Botan::secure_scrub_memory(&finalBlock, sizeof(finalBlock));
+
+            result.resize(TagSize);
+            blake2bLong(finalBytes.data(), finalBytes.size(), reinterpret_cast<quint8*>(result.data()), TagSize);
+        } catch (std::exception& e) {
+            qWarning("Argon2 error: %s", e.what());
+            return false;
+        }
+
+        return true;
+    }
+} // namespace Argon2Parallel
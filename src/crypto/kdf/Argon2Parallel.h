@@ -0,0 +1,47 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_ARGON2PARALLEL_H
+#define KEEPASSXC_ARGON2PARALLEL_H
+
+#include <QByteArray>
+
+/**
+ * Argon2 (RFC 9106) without secret and associated data, filling the lanes
+ * of every segment on a thread pool. The result is identical to the one of
+ * the reference implementation, independent of how that was built.
+ */
+namespace Argon2Parallel
+{
+    enum class Type
+    {
+        Argon2d = 0,
+        Argon2i = 1,
+        Argon2id = 2
+    };
+
+    bool hash(Type type,
+              quint32 version,
+              quint32 iterations,
+              quint32 memory,
+              quint32 lanes,
+              const QByteArray& password,
+              const QByteArray& salt,
+              QByteArray& result);
+} // namespace Argon2Parallel
+
+#endif // KEEPASSXC_ARGON2PARALLEL_H
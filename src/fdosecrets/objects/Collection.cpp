@@ -298,6 +298,7 @@ namespace FdoSecrets
             Tools::convertToRegex(value,
                                   Tools::RegexConvertOpts::EXACT_MATCH | Tools::RegexConvertOpts::CASE_SENSITIVE
                                       | Tools::RegexConvertOpts::ESCAPE_REGEX);
+        term.literals = QStringList{value};
 
         return term;
     }
@@ -18,7 +18,9 @@
 
 #include "CsvExporter.h"
 
+#include <QBuffer>
 #include <QFile>
+#include <QTextStream>
 
 #include "core/Group.h"
 
@@ -34,22 +36,36 @@ bool CsvExporter::exportDatabase(const QString& filename, const QSharedPointer<c
 
 bool CsvExporter::exportDatabase(QIODevice* device, const QSharedPointer<const Database>& db)
 {
-    if (device->write(exportHeader().toUtf8()) == -1) {
-        m_error = device->errorString();
-        return false;
-    }
+    QTextStream stream(device);
+    stream.setCodec("UTF-8");
+    return exportDatabase(stream, db);
+}
+
+/**
+ * Writes the database to the stream row by row. The rows only pass through
+ * the write buffer of the stream, so the memory used does not depend on the
+ * size of the database.
+ */
+bool CsvExporter::exportDatabase(QTextStream& stream, const QSharedPointer<const Database>& db)
+{
+    stream << exportHeader();
+    exportGroup(stream, db->rootGroup());
+    stream.flush();
 
-    if (device->write(exportGroup(db->rootGroup()).toUtf8()) == -1) {
-        m_error = device->errorString();
+    if (stream.status() != QTextStream::Ok) {
+        m_error = stream.device() ? stream.device()->errorString() : QObject::tr("Failed to write CSV data");
         return false;
     }
-
     return true;
 }
 
 QString CsvExporter::exportDatabase(const QSharedPointer<const Database>& db)
 {
-    return exportHeader() + exportGroup(db->rootGroup());
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    exportDatabase(&buffer, db);
+    return QString::fromUtf8(data);
 }
 
 QString CsvExporter::errorString() const
@@ -73,17 +89,17 @@ QString CsvExporter::exportHeader()
     return header + QString("\n");
 }
 
-QString CsvExporter::exportGroup(const Group* group, QString groupPath)
+bool CsvExporter::exportGroup(QTextStream& stream, const Group* group, QString groupPath)
 {
-    QString response;
     if (!groupPath.isEmpty()) {
         groupPath.append("/");
     }
     groupPath.append(group->name());
 
+    QString line;
     const QList<Entry*>& entryList = group->entries();
     for (const Entry* entry : entryList) {
-        QString line;
+        line.resize(0);
 
         addColumn(line, groupPath);
         addColumn(line, entry->title());
@@ -97,15 +113,22 @@ QString CsvExporter::exportGroup(const Group* group, QString groupPath)
         addColumn(line, entry->timeInfo().creationTime().toString(Qt::ISODate));
 
         line.append("\n");
-        response.append(line);
+        stream << line;
+    }
+
+    // Stop early once the device failed
+    if (stream.status() != QTextStream::Ok) {
+        return false;
     }
 
     const QList<Group*>& children = group->children();
     for (const Group* child : children) {
-        response.append(exportGroup(child, groupPath));
+        if (!exportGroup(stream, child, groupPath)) {
+            return false;
+        }
     }
 
-    return response;
+    return true;
 }
 
 void CsvExporter::addColumn(QString& str, const QString& column)
@@ -25,17 +25,19 @@
 class Database;
 class Group;
 class QIODevice;
+class QTextStream;
 
 class CsvExporter
 {
 public:
     bool exportDatabase(const QString& filename, const QSharedPointer<const Database>& db);
     bool exportDatabase(QIODevice* device, const QSharedPointer<const Database>& db);
+    bool exportDatabase(QTextStream& stream, const QSharedPointer<const Database>& db);
     QString exportDatabase(const QSharedPointer<const Database>& db);
     QString errorString() const;
 
 private:
-    QString exportGroup(const Group* group, QString groupPath = QString());
+    bool exportGroup(QTextStream& stream, const Group* group, QString groupPath = QString());
     QString exportHeader();
     void addColumn(QString& str, const QString& column);
 
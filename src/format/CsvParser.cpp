@@ -19,34 +19,35 @@
 #include "CsvParser.h"
 
 #include <QFile>
+#include <QScopedPointer>
 #include <QTextCodec>
 
-#include "core/Tools.h"
+namespace
+{
+    // Bytes read and decoded at once
+    const int ChunkSize = 64 * 1024;
+} // namespace
 
 CsvParser::CsvParser()
-    : m_ch(0)
+    : m_fileSize(0)
+    , m_codec(QTextCodec::codecForName("UTF-8"))
     , m_comment('#')
     , m_currCol(1)
     , m_currRow(1)
     , m_isBackslashSyntax(false)
-    , m_isEof(false)
     , m_isFileLoaded(false)
     , m_isGood(true)
-    , m_lastPos(-1)
     , m_maxCols(0)
     , m_qualifier('"')
     , m_separator(',')
     , m_statusMsg("")
+    , m_state(RecordStart)
+    , m_skipLineFeed(false)
 {
-    m_csv.setBuffer(&m_array);
-    m_ts.setDevice(&m_csv);
-    m_csv.open(QIODevice::ReadOnly);
-    m_ts.setCodec("UTF-8");
 }
 
 CsvParser::~CsvParser()
 {
-    m_csv.close();
 }
 
 bool CsvParser::isFileLoaded()
@@ -57,7 +58,16 @@ bool CsvParser::isFileLoaded()
 bool CsvParser::reparse()
 {
     reset();
-    return parseFile();
+    if (!m_isFileLoaded) {
+        return m_isGood;
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        appendStatusMsg(QObject::tr("error reading from device"), true);
+        return false;
+    }
+    return parseDevice(&file);
 }
 
 bool CsvParser::parse(QFile* device)
@@ -67,46 +77,39 @@ bool CsvParser::parse(QFile* device)
         appendStatusMsg(QObject::tr("NULL device"), true);
         return false;
     }
-    if (!readFile(device)) {
-        return false;
-    }
-    return parseFile();
-}
 
-bool CsvParser::readFile(QFile* device)
-{
+    // Closing the device flushes pending writes, e.g. of a QTextStream
     if (device->isOpen()) {
         device->close();
     }
-
-    device->open(QIODevice::ReadOnly);
-    if (!Tools::readAllFromDevice(device, m_array)) {
+    if (!device->open(QIODevice::ReadOnly)) {
         appendStatusMsg(QObject::tr("error reading from device"), true);
-        m_isFileLoaded = false;
-    } else {
-        device->close();
+        return false;
+    }
 
-        m_array.replace("\r\n", "\n");
-        m_array.replace("\r", "\n");
-        if (m_array.isEmpty()) {
-            appendStatusMsg(QObject::tr("file empty").append("\n"));
-        }
-        m_isFileLoaded = true;
+    m_fileName = device->fileName();
+    m_fileSize = device->size();
+    m_isFileLoaded = true;
+    if (m_fileSize == 0) {
+        appendStatusMsg(QObject::tr("file empty").append("\n"));
     }
-    return m_isFileLoaded;
+
+    bool result = parseDevice(device);
+    device->close();
+    return result;
 }
 
 void CsvParser::reset()
 {
-    m_ch = 0;
     m_currCol = 1;
     m_currRow = 1;
-    m_isEof = false;
     m_isGood = true;
-    m_lastPos = -1;
     m_maxCols = 0;
     m_statusMsg = "";
-    m_ts.seek(0);
+    m_state = RecordStart;
+    m_skipLineFeed = false;
+    m_field.clear();
+    m_row.clear();
     m_table.clear();
     // the following are users' concern :)
     // m_comment = '#';
@@ -120,225 +123,235 @@ void CsvParser::clear()
 {
     reset();
     m_isFileLoaded = false;
-    m_array.clear();
-}
-
-bool CsvParser::parseFile()
-{
-    parseRecord();
-    while (!m_isEof) {
-        if (!skipEndline()) {
-            appendStatusMsg(QObject::tr("malformed string"), true);
-        }
-        m_currRow++;
-        m_currCol = 1;
-        parseRecord();
-    }
-    fillColumns();
-    return m_isGood;
+    m_fileName.clear();
+    m_fileSize = 0;
 }
 
-void CsvParser::parseRecord()
+/**
+ * Computes the character classes and the transitions of the state machine
+ * for the current settings.
+ */
+void CsvParser::buildTables()
 {
-    CsvRow row;
-    if (isComment()) {
-        skipLine();
-        return;
+    for (int i = 0; i < 128; ++i) {
+        m_charClasses[i] = charClass(QChar(i));
     }
-    do {
-        parseField(row);
-        getChar(m_ch);
-    } while (isSeparator(m_ch) && !m_isEof);
 
-    if (!m_isEof) {
-        ungetChar();
-    }
-    if (isEmptyRow(row)) {
-        row.clear();
-        return;
-    }
-    m_table.push_back(row);
-    if (m_maxCols < row.size()) {
-        m_maxCols = row.size();
-    }
-    m_currCol++;
-}
-
-void CsvParser::parseField(CsvRow& row)
-{
-    QString field;
-    peek(m_ch);
-    if (!isTerminator(m_ch)) {
-        if (isQualifier(m_ch)) {
-            parseQuoted(field);
-        } else {
-            parseSimple(field);
+    auto set = [this](State state, CharClass type, Action action, State next) {
+        m_transitions[state][type] = {action, next};
+    };
+    auto setAll = [this](State state, Action action, State next) {
+        for (int i = 0; i < CharClassCount; ++i) {
+            m_transitions[state][i] = {action, next};
+        }
+    };
+
+    // Comments and leading blanks are only recognized at the start of a record
+    setAll(RecordStart, AppendChar, Simple);
+    set(RecordStart, BlankChar, AppendChar, LeadingBlank);
+    set(RecordStart, CommentChar, NoAction, Comment);
+    set(RecordStart, QualifierChar, NoAction, Quoted);
+    set(RecordStart, SeparatorChar, EndField, FieldStart);
+    set(RecordStart, NewlineChar, EndRecord, RecordStart);
+
+    setAll(LeadingBlank, AppendChar, Simple);
+    set(LeadingBlank, BlankChar, AppendChar, LeadingBlank);
+    set(LeadingBlank, CommentChar, ClearField, Comment);
+    set(LeadingBlank, SeparatorChar, EndField, FieldStart);
+    set(LeadingBlank, NewlineChar, EndRecord, RecordStart);
+
+    setAll(FieldStart, AppendChar, Simple);
+    set(FieldStart, QualifierChar, NoAction, Quoted);
+    set(FieldStart, SeparatorChar, EndField, FieldStart);
+    set(FieldStart, NewlineChar, EndRecord, RecordStart);
+
+    // Qualifiers inside of unquoted fields are plain text
+    setAll(Simple, AppendChar, Simple);
+    set(Simple, SeparatorChar, EndField, FieldStart);
+    set(Simple, NewlineChar, EndRecord, RecordStart);
+
+    setAll(Quoted, AppendChar, Quoted);
+    set(Quoted, NewlineChar, AppendNewline, Quoted);
+    set(Quoted, EscapeChar, NoAction, QuotedEscape);
+    set(Quoted, QualifierChar, NoAction, m_isBackslashSyntax ? AfterQuoted : QuotedQualifier);
+
+    setAll(QuotedEscape, AppendChar, Quoted);
+    set(QuotedEscape, NewlineChar, AppendNewline, Quoted);
+
+    // A qualifier that is either doubled or closes the field
+    setAll(QuotedQualifier, Malformed, RecordStart);
+    set(QuotedQualifier, QualifierChar, AppendChar, Quoted);
+    set(QuotedQualifier, SeparatorChar, EndField, FieldStart);
+    set(QuotedQualifier, NewlineChar, EndRecord, RecordStart);
+
+    setAll(AfterQuoted, Malformed, RecordStart);
+    set(AfterQuoted, SeparatorChar, EndField, FieldStart);
+    set(AfterQuoted, NewlineChar, EndRecord, RecordStart);
+
+    setAll(Comment, NoAction, Comment);
+    set(Comment, NewlineChar, NoAction, RecordStart);
+}
+
+bool CsvParser::parseDevice(QIODevice* device)
+{
+    buildTables();
+
+    QScopedPointer<QTextDecoder> decoder;
+    QByteArray buffer(ChunkSize, Qt::Uninitialized);
+    while (true) {
+        qint64 bytesRead = device->read(buffer.data(), ChunkSize);
+        if (bytesRead < 0) {
+            appendStatusMsg(QObject::tr("error reading from device"), true);
+            break;
+        } else if (bytesRead == 0) {
+            break;
         }
-    }
-    row.push_back(field);
-}
-
-void CsvParser::parseSimple(QString& s)
-{
-    QChar c;
-    getChar(c);
-    while ((isText(c)) && (!m_isEof)) {
-        s.append(c);
-        getChar(c);
-    }
-    if (!m_isEof) {
-        ungetChar();
-    }
-}
 
-void CsvParser::parseQuoted(QString& s)
-{
-    // read and discard initial qualifier (e.g. quote)
-    getChar(m_ch);
-    parseEscaped(s);
-    if (!isQualifier(m_ch)) {
-        appendStatusMsg(QObject::tr("missing closing quote"), true);
+        if (!decoder) {
+            // Honor a byte order mark like QTextStream does
+            const auto head = QByteArray::fromRawData(buffer.constData(), static_cast<int>(bytesRead));
+            decoder.reset(QTextCodec::codecForUtfText(head, m_codec)->makeDecoder());
+        }
+        const QString text = decoder->toUnicode(buffer.constData(), static_cast<int>(bytesRead));
+        parseChunk(text.constData(), text.size());
     }
-}
 
-void CsvParser::parseEscaped(QString& s)
-{
-    parseEscapedText(s);
-    while (processEscapeMark(s, m_ch)) {
-        parseEscapedText(s);
-    }
-    if (!m_isEof) {
-        ungetChar();
-    }
+    finishParsing();
+    fillColumns();
+    return m_isGood;
 }
 
-void CsvParser::parseEscapedText(QString& s)
+/**
+ * Runs the state machine over a chunk of decoded text. Consecutive
+ * characters of a field are appended at once.
+ */
+void CsvParser::parseChunk(const QChar* data, int size)
 {
-    getChar(m_ch);
-    while ((!isQualifier(m_ch)) && !m_isEof) {
-        s.append(m_ch);
-        getChar(m_ch);
-    }
-}
+    int runStart = -1;
 
-bool CsvParser::processEscapeMark(QString& s, QChar c)
-{
-    QChar buf;
-    peek(buf);
-    QChar c2;
-    if (true == m_isBackslashSyntax) {
-        // escape-character syntax, e.g. \"
-        if (c != '\\') {
-            return false;
-        }
-        // consume (and append) second qualifier
-        getChar(c2);
-        if (m_isEof) {
-            c2 = '\\';
-            s.append('\\');
-            return false;
-        } else {
-            s.append(c2);
-            return true;
-        }
-    } else {
-        // double quote syntax, e.g. ""
-        if (!isQualifier(c)) {
-            return false;
-        }
-        peek(c2);
-        if (!m_isEof) { // not EOF, can read one char
-            if (isQualifier(c2)) {
-                s.append(c2);
-                getChar(c2);
-                return true;
+    for (int i = 0; i < size; ++i) {
+        const ushort code = data[i].unicode();
+        if (m_skipLineFeed) {
+            // Second half of a CRLF line break
+            m_skipLineFeed = false;
+            if (code == '\n') {
+                continue;
             }
         }
-        return false;
-    }
-}
 
-void CsvParser::fillColumns()
-{
-    // fill shorter rows with empty placeholder columns
-    for (int i = 0; i < m_table.size(); ++i) {
-        int gap = m_maxCols - m_table.at(i).size();
-        if (gap > 0) {
-            CsvRow r = m_table.at(i);
-            for (int j = 0; j < gap; ++j) {
-                r.append(QString(""));
+        const int type = code < 128 ? m_charClasses[code] : charClass(data[i]);
+        const Transition& transition = m_transitions[m_state][type];
+        if (transition.action == AppendChar) {
+            if (runStart < 0) {
+                runStart = i;
             }
-            m_table.replace(i, r);
+            m_state = transition.next;
+            continue;
         }
-    }
-}
 
-void CsvParser::skipLine()
-{
-    m_ts.readLine();
-    m_ts.seek(m_ts.pos() - 1);
-}
+        if (runStart >= 0) {
+            m_field.append(data + runStart, i - runStart);
+            runStart = -1;
+        }
 
-bool CsvParser::skipEndline()
-{
-    getChar(m_ch);
-    return (m_ch == '\n');
-}
+        if (transition.action == Malformed) {
+            // Text after a closing qualifier, parse it as the start of a new record
+            appendStatusMsg(QObject::tr("malformed string"), true);
+            endRecord();
+            m_state = RecordStart;
+            --i;
+            continue;
+        } else if (transition.action == AppendNewline) {
+            m_field.append('\n');
+        } else if (transition.action == ClearField) {
+            m_field.clear();
+        } else if (transition.action == EndField) {
+            endField();
+        } else if (transition.action == EndRecord) {
+            endRecord();
+        }
 
-void CsvParser::getChar(QChar& c)
-{
-    m_isEof = m_ts.atEnd();
-    if (!m_isEof) {
-        m_lastPos = m_ts.pos();
-        m_ts >> c;
+        if (type == NewlineChar) {
+            m_skipLineFeed = code == '\r';
+            m_currRow++;
+        }
+        m_state = transition.next;
+    }
+
+    if (runStart >= 0) {
+        m_field.append(data + runStart, size - runStart);
     }
 }
 
-void CsvParser::ungetChar()
+void CsvParser::finishParsing()
 {
-    if (!m_ts.seek(m_lastPos)) {
-        qWarning("CSV Parser: unget lower bound exceeded");
-        m_isGood = false;
+    switch (m_state) {
+    case QuotedEscape:
+    case Quoted:
+        if (m_state == QuotedEscape) {
+            // A lone escape character at the end is taken literally
+            m_field.append('\\');
+        }
+        appendStatusMsg(QObject::tr("missing closing quote"), true);
+        endRecord();
+        break;
+    case RecordStart:
+    case Comment:
+        break;
+    default:
+        endRecord();
+        break;
     }
+    m_state = RecordStart;
 }
 
-void CsvParser::peek(QChar& c)
+void CsvParser::endField()
 {
-    getChar(c);
-    if (!m_isEof) {
-        ungetChar();
-    }
+    m_row.append(m_field);
+    m_field.clear();
+    m_currCol++;
 }
 
-bool CsvParser::isQualifier(const QChar& c) const
+void CsvParser::endRecord()
 {
-    if (true == m_isBackslashSyntax && (c != m_qualifier)) {
-        return (c == '\\');
-    } else {
-        return (c == m_qualifier);
+    endField();
+    if (!isEmptyRow(m_row)) {
+        m_table.append(m_row);
+        if (m_maxCols < m_row.size()) {
+            m_maxCols = m_row.size();
+        }
     }
+    m_row.clear();
+    m_currCol = 1;
 }
 
-bool CsvParser::isComment()
+void CsvParser::fillColumns()
 {
-    bool result = false;
-    QChar c2;
-    qint64 pos = m_ts.pos();
-
-    do {
-        getChar(c2);
-    } while ((isSpace(c2) || isTab(c2)) && (!m_isEof));
-
-    if (c2 == m_comment) {
-        result = true;
+    // fill shorter rows with empty placeholder columns
+    for (auto& row : m_table) {
+        while (row.size() < m_maxCols) {
+            row.append(QString(""));
+        }
     }
-    m_ts.seek(pos);
-    return result;
 }
 
-bool CsvParser::isText(QChar c) const
-{
-    return !((isCRLF(c)) || (isSeparator(c)));
+CsvParser::CharClass CsvParser::charClass(QChar c) const
+{
+    // Earlier checks take precedence, e.g. a tab used as separator is not blank
+    if (c == m_separator) {
+        return SeparatorChar;
+    } else if (c == m_qualifier) {
+        return QualifierChar;
+    } else if (c == '\n' || c == '\r') {
+        return NewlineChar;
+    } else if (m_isBackslashSyntax && c == '\\') {
+        return EscapeChar;
+    } else if (c == m_comment) {
+        return CommentChar;
+    } else if (c == ' ' || c == '\t') {
+        return BlankChar;
+    }
+    return TextChar;
 }
 
 bool CsvParser::isEmptyRow(const CsvRow& row) const
@@ -352,31 +365,6 @@ bool CsvParser::isEmptyRow(const CsvRow& row) const
     return true;
 }
 
-bool CsvParser::isCRLF(const QChar& c) const
-{
-    return (c == '\n');
-}
-
-bool CsvParser::isSpace(const QChar& c) const
-{
-    return (c == ' ');
-}
-
-bool CsvParser::isTab(const QChar& c) const
-{
-    return (c == '\t');
-}
-
-bool CsvParser::isSeparator(const QChar& c) const
-{
-    return (c == m_separator);
-}
-
-bool CsvParser::isTerminator(const QChar& c) const
-{
-    return (isSeparator(c) || (c == '\n') || (c == '\r'));
-}
-
 void CsvParser::setBackslashSyntax(bool set)
 {
     m_isBackslashSyntax = set;
@@ -389,7 +377,10 @@ void CsvParser::setComment(const QChar& c)
 
 void CsvParser::setCodec(const QString& s)
 {
-    m_ts.setCodec(QTextCodec::codecForName(s.toLocal8Bit()));
+    auto codec = QTextCodec::codecForName(s.toLocal8Bit());
+    if (codec) {
+        m_codec = codec;
+    }
 }
 
 void CsvParser::setFieldSeparator(const QChar& c)
@@ -404,7 +395,7 @@ void CsvParser::setTextQualifier(const QChar& c)
 
 int CsvParser::getFileSize() const
 {
-    return m_csv.size();
+    return static_cast<int>(m_fileSize);
 }
 
 const CsvTable CsvParser::getCsvTable() const
@@ -433,6 +424,6 @@ int CsvParser::getCsvRows() const
 
 void CsvParser::appendStatusMsg(const QString& s, bool isCritical)
 {
-    m_statusMsg += QObject::tr("%1: (row, col) %2,%3").arg(s, m_currRow, m_currCol).append("\n");
+    m_statusMsg += QObject::tr("%1: (row, col) %2,%3").arg(s).arg(m_currRow).arg(m_currCol).append("\n");
     m_isGood = !isCritical;
 }
@@ -19,14 +19,23 @@
 #ifndef KEEPASSX_CSVPARSER_H
 #define KEEPASSX_CSVPARSER_H
 
-#include <QBuffer>
-#include <QTextStream>
+#include <QStringList>
 
 class QFile;
+class QIODevice;
+class QTextCodec;
 
 typedef QStringList CsvRow;
 typedef QList<CsvRow> CsvTable;
 
+/**
+ * Streaming CSV parser.
+ *
+ * The file is read and decoded in chunks and every chunk is run through a
+ * state machine whose transitions are computed from the separator,
+ * qualifier, comment and escape settings before each parse. Only the
+ * parsed rows are kept in memory, reparsing reads the file again.
+ */
 class CsvParser
 {
 
@@ -36,7 +45,7 @@ public:
     // read data from device and parse it
     bool parse(QFile* device);
     bool isFileLoaded();
-    // reparse the same buffer (device is not opened again)
+    // parse the same file again with the current settings
     bool reparse();
     void setCodec(const QString& s);
     void setComment(const QChar& c);
@@ -53,49 +62,82 @@ protected:
     CsvTable m_table;
 
 private:
-    QByteArray m_array;
-    QBuffer m_csv;
-    QChar m_ch;
+    enum CharClass
+    {
+        TextChar,
+        SeparatorChar,
+        QualifierChar,
+        EscapeChar,
+        NewlineChar,
+        BlankChar,
+        CommentChar,
+        CharClassCount
+    };
+
+    enum State
+    {
+        RecordStart,
+        LeadingBlank,
+        FieldStart,
+        Simple,
+        Quoted,
+        QuotedEscape,
+        QuotedQualifier,
+        AfterQuoted,
+        Comment,
+        StateCount
+    };
+
+    enum Action
+    {
+        NoAction,
+        AppendChar,
+        AppendNewline,
+        ClearField,
+        EndField,
+        EndRecord,
+        Malformed
+    };
+
+    struct Transition
+    {
+        Action action = NoAction;
+        State next = RecordStart;
+    };
+
+    QString m_fileName;
+    qint64 m_fileSize;
+    QTextCodec* m_codec;
     QChar m_comment;
     unsigned int m_currCol;
     unsigned int m_currRow;
     bool m_isBackslashSyntax;
-    bool m_isEof;
     bool m_isFileLoaded;
     bool m_isGood;
-    qint64 m_lastPos;
     int m_maxCols;
     QChar m_qualifier;
     QChar m_separator;
     QString m_statusMsg;
-    QTextStream m_ts;
 
-    void getChar(QChar& c);
-    void ungetChar();
-    void peek(QChar& c);
+    // Parsing state, kept across chunks
+    quint8 m_charClasses[128];
+    Transition m_transitions[StateCount][CharClassCount];
+    State m_state;
+    bool m_skipLineFeed;
+    QString m_field;
+    CsvRow m_row;
+
     void fillColumns();
-    bool isTerminator(const QChar& c) const;
-    bool isSeparator(const QChar& c) const;
-    bool isQualifier(const QChar& c) const;
-    bool processEscapeMark(QString& s, QChar c);
-    bool isText(QChar c) const;
-    bool isComment();
-    bool isCRLF(const QChar& c) const;
-    bool isSpace(const QChar& c) const;
-    bool isTab(const QChar& c) const;
+    CharClass charClass(QChar c) const;
     bool isEmptyRow(const CsvRow& row) const;
-    bool parseFile();
-    void parseRecord();
-    void parseField(CsvRow& row);
-    void parseSimple(QString& s);
-    void parseQuoted(QString& s);
-    void parseEscaped(QString& s);
-    void parseEscapedText(QString& s);
-    bool readFile(QFile* device);
+    void buildTables();
+    bool parseDevice(QIODevice* device);
+    void parseChunk(const QChar* data, int size);
+    void finishParsing();
+    void endField();
+    void endRecord();
     void reset();
     void clear();
-    bool skipEndline();
-    void skipLine();
     void appendStatusMsg(const QString& s, bool isCritical = false);
 };
 
@@ -27,9 +27,8 @@
 #include "format/KdbxXmlReader.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HmacBlockStream.h"
+#include "streams/HmacDecryptStream.h"
 #include "streams/StoreDataStream.h"
-#include "streams/SymmetricCipherStream.h"
-#include "streams/qtiocompressor.h"
 
 bool Kdbx4Reader::readDatabaseImpl(QIODevice* device,
                                    const QByteArray& headerData,
@@ -79,42 +78,24 @@ bool Kdbx4Reader::readDatabaseImpl(QIODevice* device,
                       "If this reoccurs, then your database file may be corrupt.") + " " + tr("(HMAC mismatch)"));
         return false;
     }
-    HmacBlockStream hmacStream(device, hmacKey);
-    if (!hmacStream.open(QIODevice::ReadOnly)) {
-        raiseError(hmacStream.errorString());
-        return false;
-    }
+    // clang-format on
 
     auto mode = SymmetricCipher::cipherUuidToMode(db->cipher());
     if (mode == SymmetricCipher::InvalidMode) {
         raiseError(tr("Unknown cipher"));
         return false;
     }
-    SymmetricCipherStream cipherStream(&hmacStream);
-    if (!cipherStream.init(mode, SymmetricCipher::Decrypt, finalKey, m_encryptionIV)) {
-        raiseError(cipherStream.errorString());
+    bool compressed = db->compressionAlgorithm() != Database::CompressionNone;
+    HmacDecryptStream payloadStream(device, hmacKey);
+    if (!payloadStream.init(mode, finalKey, m_encryptionIV, compressed)) {
+        raiseError(payloadStream.errorString());
         return false;
     }
-    if (!cipherStream.open(QIODevice::ReadOnly)) {
-        raiseError(cipherStream.errorString());
+    if (!payloadStream.open(QIODevice::ReadOnly)) {
+        raiseError(payloadStream.errorString());
         return false;
     }
-    // clang-format on
-
-    QIODevice* xmlDevice = nullptr;
-    QScopedPointer<QtIOCompressor> ioCompressor;
-
-    if (db->compressionAlgorithm() == Database::CompressionNone) {
-        xmlDevice = &cipherStream;
-    } else {
-        ioCompressor.reset(new QtIOCompressor(&cipherStream));
-        ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        if (!ioCompressor->open(QIODevice::ReadOnly)) {
-            raiseError(ioCompressor->errorString());
-            return false;
-        }
-        xmlDevice = ioCompressor.data();
-    }
+    QIODevice* xmlDevice = &payloadStream;
 
     while (readInnerHeaderField(xmlDevice) && !hasError()) {
     }
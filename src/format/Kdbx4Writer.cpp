@@ -24,8 +24,7 @@
 #include "format/KdbxXmlWriter.h"
 #include "format/KeePass2RandomStream.h"
 #include "streams/HmacBlockStream.h"
-#include "streams/SymmetricCipherStream.h"
-#include "streams/qtiocompressor.h"
+#include "streams/HmacEncryptStream.h"
 
 bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
 {
@@ -111,42 +110,17 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     CHECK_RETURN_FALSE(writeData(device, headerHash));
     CHECK_RETURN_FALSE(writeData(device, headerHmac));
 
-    QScopedPointer<HmacBlockStream> hmacBlockStream;
-    QScopedPointer<SymmetricCipherStream> cipherStream;
-
-    hmacBlockStream.reset(new HmacBlockStream(device, hmacKey));
-    if (!hmacBlockStream->open(QIODevice::WriteOnly)) {
-        raiseError(hmacBlockStream->errorString());
-        return false;
-    }
-
-    cipherStream.reset(new SymmetricCipherStream(hmacBlockStream.data()));
-
-    if (!cipherStream->init(mode, SymmetricCipher::Encrypt, finalKey, encryptionIV)) {
-        raiseError(cipherStream->errorString());
+    HmacEncryptStream payloadStream(device, hmacKey);
+    bool compressed = db->compressionAlgorithm() != Database::CompressionNone;
+    if (!payloadStream.init(mode, finalKey, encryptionIV, compressed)) {
+        raiseError(payloadStream.errorString());
         return false;
     }
-    if (!cipherStream->open(QIODevice::WriteOnly)) {
-        raiseError(cipherStream->errorString());
+    if (!payloadStream.open(QIODevice::WriteOnly)) {
+        raiseError(payloadStream.errorString());
         return false;
     }
-
-    QIODevice* outputDevice = nullptr;
-    QScopedPointer<QtIOCompressor> ioCompressor;
-
-    if (db->compressionAlgorithm() == Database::CompressionNone) {
-        outputDevice = cipherStream.data();
-    } else {
-        ioCompressor.reset(new QtIOCompressor(cipherStream.data()));
-        ioCompressor->setStreamFormat(QtIOCompressor::GzipFormat);
-        if (!ioCompressor->open(QIODevice::WriteOnly)) {
-            raiseError(ioCompressor->errorString());
-            return false;
-        }
-        outputDevice = ioCompressor.data();
-    }
-
-    Q_ASSERT(outputDevice);
+    QIODevice* outputDevice = &payloadStream;
 
     CHECK_RETURN_FALSE(writeInnerHeaderField(
         outputDevice,
@@ -169,17 +143,10 @@ bool Kdbx4Writer::writeDatabase(QIODevice* device, Database* db)
     KdbxXmlWriter xmlWriter(db->formatVersion());
     xmlWriter.writeDatabase(outputDevice, db, &randomStream, headerHash);
 
-    // Explicitly close/reset streams so they are flushed and we can detect
-    // errors. QIODevice::close() resets errorString() etc.
-    if (ioCompressor) {
-        ioCompressor->close();
-    }
-    if (!cipherStream->reset()) {
-        raiseError(cipherStream->errorString());
-        return false;
-    }
-    if (!hmacBlockStream->reset()) {
-        raiseError(hmacBlockStream->errorString());
+    // Explicitly reset the stream so pending blocks are written and we can
+    // detect errors. QIODevice::close() resets errorString() etc.
+    if (!payloadStream.reset()) {
+        raiseError(payloadStream.errorString());
         return false;
     }
 
@@ -219,15 +186,16 @@ void Kdbx4Writer::writeAttachments(QIODevice* device, Database* db)
     for (Entry* entry : allEntries) {
         const QList<QString> attachmentKeys = entry->attachments()->keys();
         for (const QString& key : attachmentKeys) {
-            QByteArray data("\x01");
-            data.append(entry->attachments()->value(key));
-
-            if (writtenAttachments.contains(data)) {
+            // Identical attachments share the same hash, which is computed once when they are stored
+            const QByteArray hash = entry->attachments()->hash(key);
+            if (writtenAttachments.contains(hash)) {
                 continue;
             }
 
+            QByteArray data("\x01");
+            data.append(entry->attachments()->value(key));
             writeInnerHeaderField(device, KeePass2::InnerHeaderFieldID::Binary, data);
-            writtenAttachments.insert(data);
+            writtenAttachments.insert(hash);
         }
     }
 }
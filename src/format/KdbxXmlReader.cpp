@@ -21,13 +21,128 @@
 #include "core/Endian.h"
 #include "core/Group.h"
 #include "core/Tools.h"
-#include "streams/qtiocompressor.h"
 
-#include <QBuffer>
 #include <QFile>
 
+#include <cstring>
+#include <zlib.h>
+
 #define UUID_LENGTH 16
 
+namespace
+{
+    // Characters of base64 text decoded at once, keeps the temporary buffers small
+    const int Base64SliceSize = 64 * 1024;
+
+    /**
+     * Incremental base64 decoder with the semantics of QByteArray::fromBase64,
+     * characters outside of the base64 alphabet are skipped.
+     */
+    class Base64Decoder
+    {
+    public:
+        void decode(const QStringRef& text, QByteArray& output)
+        {
+            for (const QChar c : text) {
+                const ushort ch = c.unicode();
+                int d;
+                if (ch >= 'A' && ch <= 'Z') {
+                    d = ch - 'A';
+                } else if (ch >= 'a' && ch <= 'z') {
+                    d = ch - 'a' + 26;
+                } else if (ch >= '0' && ch <= '9') {
+                    d = ch - '0' + 52;
+                } else if (ch == '+') {
+                    d = 62;
+                } else if (ch == '/') {
+                    d = 63;
+                } else {
+                    continue;
+                }
+
+                m_buffer = (m_buffer << 6) | static_cast<uint>(d);
+                m_bits += 6;
+                if (m_bits >= 8) {
+                    m_bits -= 8;
+                    output.append(static_cast<char>(m_buffer >> m_bits));
+                    m_buffer &= (1u << m_bits) - 1;
+                }
+            }
+        }
+
+    private:
+        uint m_buffer = 0;
+        int m_bits = 0;
+    };
+
+    /**
+     * Incremental gzip decompressor appending to the output buffer.
+     */
+    class GzipInflater
+    {
+    public:
+        GzipInflater()
+        {
+            std::memset(&m_stream, 0, sizeof(m_stream));
+            // 16 selects the gzip format
+            m_valid = inflateInit2(&m_stream, MAX_WBITS + 16) == Z_OK;
+        }
+
+        ~GzipInflater()
+        {
+            inflateEnd(&m_stream);
+        }
+
+        bool inflate(const QByteArray& input, QByteArray& output)
+        {
+            if (!m_valid || input.isEmpty()) {
+                return m_valid;
+            }
+            m_started = true;
+            if (m_finished) {
+                // Ignore data after the end of the gzip stream
+                return true;
+            }
+
+            const int chunkSize = 64 * 1024;
+            m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+            m_stream.avail_in = static_cast<uInt>(input.size());
+            do {
+                const int offset = output.size();
+                output.resize(offset + chunkSize);
+                m_stream.next_out = reinterpret_cast<Bytef*>(output.data() + offset);
+                m_stream.avail_out = chunkSize;
+
+                const int result = ::inflate(&m_stream, Z_NO_FLUSH);
+                output.resize(offset + chunkSize - static_cast<int>(m_stream.avail_out));
+
+                if (result == Z_STREAM_END) {
+                    m_finished = true;
+                    break;
+                } else if (result == Z_BUF_ERROR) {
+                    break;
+                } else if (result != Z_OK) {
+                    m_valid = false;
+                    break;
+                }
+            } while (m_stream.avail_out == 0);
+
+            return m_valid;
+        }
+
+        bool finish() const
+        {
+            return m_valid && (m_finished || !m_started);
+        }
+
+    private:
+        z_stream m_stream;
+        bool m_valid = false;
+        bool m_started = false;
+        bool m_finished = false;
+    };
+} // namespace
+
 /**
  * @param version KDBX version
  */
@@ -1130,45 +1245,80 @@ QUuid KdbxXmlReader::readUuid()
 
 QByteArray KdbxXmlReader::readBinary()
 {
-    QXmlStreamAttributes attr = m_xml.attributes();
-    bool isProtected = isTrueValue(attr.value("Protected"));
-    QString value = m_xml.readElementText();
-    QByteArray data = QByteArray::fromBase64(value.toLatin1());
-
-    if (isProtected && !data.isEmpty()) {
-        bool ok;
-        QByteArray plaintext = m_randomStream->process(data, &ok);
-        if (!ok) {
-            data.clear();
-            raiseError(m_randomStream->errorString());
-            return data;
-        }
-
-        data = plaintext;
-    }
-
+    QByteArray data;
+    readBinaryText([&data](QByteArray& slice) {
+        data.append(slice);
+        return true;
+    });
     return data;
 }
 
 QByteArray KdbxXmlReader::readCompressedBinary()
 {
-    QByteArray rawData = readBinary();
-
-    QBuffer buffer(&rawData);
-    buffer.open(QIODevice::ReadOnly);
-
-    QtIOCompressor compressor(&buffer);
-    compressor.setStreamFormat(QtIOCompressor::GzipFormat);
-    compressor.open(QIODevice::ReadOnly);
-
     QByteArray result;
-    if (!Tools::readAllFromDevice(&compressor, result)) {
+    GzipInflater inflater;
+    bool ok = readBinaryText([&inflater, &result](QByteArray& slice) { return inflater.inflate(slice, result); });
+
+    if (ok && !inflater.finish()) {
+        ok = false;
+    }
+    if (!ok && !hasError()) {
         //: Translator meant is a binary data inside an entry
         raiseError(tr("Unable to decompress binary"));
     }
     return result;
 }
 
+/**
+ * Decodes the base64 text of the current element slice by slice and passes
+ * the decoded, unprotected data to the consumer, so the decoded binary is
+ * built in chunks instead of from one decoded copy of the whole text.
+ *
+ * @param consumer receives every decoded slice, returns false to stop
+ * @return true if the element was read completely
+ */
+bool KdbxXmlReader::readBinaryText(const std::function<bool(QByteArray&)>& consumer)
+{
+    Q_ASSERT(m_xml.isStartElement());
+
+    const bool isProtected = isTrueValue(m_xml.attributes().value("Protected"));
+    Base64Decoder decoder;
+    QByteArray slice;
+    bool ok = true;
+
+    while (!m_xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = m_xml.readNext();
+        if (token == QXmlStreamReader::EndElement) {
+            break;
+        } else if (token == QXmlStreamReader::StartElement) {
+            m_xml.raiseError(tr("Expected character data"));
+            return false;
+        } else if (token != QXmlStreamReader::Characters || !ok) {
+            // Skip comments and processing instructions, and the rest of the element after an error
+            continue;
+        }
+
+        const QStringRef text = m_xml.text();
+        for (int pos = 0; pos < text.size() && ok; pos += Base64SliceSize) {
+            slice.clear();
+            decoder.decode(text.mid(pos, Base64SliceSize), slice);
+            if (slice.isEmpty()) {
+                continue;
+            }
+
+            if (isProtected && !m_randomStream->processInPlace(slice)) {
+                raiseError(m_randomStream->errorString());
+                ok = false;
+                break;
+            }
+
+            ok = consumer(slice);
+        }
+    }
+
+    return ok && !m_xml.hasError();
+}
+
 Group* KdbxXmlReader::getGroup(const QUuid& uuid)
 {
     if (uuid.isNull()) {
@@ -24,6 +24,8 @@
 #include <QCoreApplication>
 #include <QXmlStreamReader>
 
+#include <functional>
+
 class QIODevice;
 class Group;
 class Entry;
@@ -86,6 +88,7 @@ protected:
     virtual QUuid readUuid();
     virtual QByteArray readBinary();
     virtual QByteArray readCompressedBinary();
+    bool readBinaryText(const std::function<bool(QByteArray&)>& consumer);
 
     virtual void skipCurrentElement();
 
@@ -84,13 +84,16 @@ void KdbxXmlWriter::generateIdMap()
 {
     const QList<Entry*> allEntries = m_db->rootGroup()->entriesRecursive(true);
     int nextId = 0;
+    m_idMap.clear();
+    m_binaries.clear();
 
     for (Entry* entry : allEntries) {
         const QList<QString> attachmentKeys = entry->attachments()->keys();
         for (const QString& key : attachmentKeys) {
-            QByteArray data = entry->attachments()->value(key);
-            if (!m_idMap.contains(data)) {
-                m_idMap.insert(data, nextId++);
+            const QByteArray hash = entry->attachments()->hash(key);
+            if (!m_idMap.contains(hash)) {
+                m_idMap.insert(hash, nextId++);
+                m_binaries.append(entry->attachments()->value(key));
             }
         }
     }
@@ -183,11 +186,11 @@ void KdbxXmlWriter::writeBinaries()
 {
     m_xml.writeStartElement("Binaries");
 
-    QHash<QByteArray, int>::const_iterator i;
-    for (i = m_idMap.constBegin(); i != m_idMap.constEnd(); ++i) {
+    for (int id = 0; id < m_binaries.size(); ++id) {
+        const QByteArray& binary = m_binaries.at(id);
         m_xml.writeStartElement("Binary");
 
-        m_xml.writeAttribute("ID", QString::number(i.value()));
+        m_xml.writeAttribute("ID", QString::number(id));
 
         QByteArray data;
         if (m_db->compressionAlgorithm() == Database::CompressionGZip) {
@@ -200,15 +203,15 @@ void KdbxXmlWriter::writeBinaries()
             compressor.setStreamFormat(QtIOCompressor::GzipFormat);
             compressor.open(QIODevice::WriteOnly);
 
-            qint64 bytesWritten = compressor.write(i.key());
-            Q_ASSERT(bytesWritten == i.key().size());
+            qint64 bytesWritten = compressor.write(binary);
+            Q_ASSERT(bytesWritten == binary.size());
             Q_UNUSED(bytesWritten);
             compressor.close();
 
             buffer.seek(0);
             data = buffer.readAll();
         } else {
-            data = i.key();
+            data = binary;
         }
 
         if (!data.isEmpty()) {
@@ -422,7 +425,7 @@ void KdbxXmlWriter::writeEntry(const Entry* entry)
         writeString("Key", key);
 
         m_xml.writeStartElement("Value");
-        m_xml.writeAttribute("Ref", QString::number(m_idMap[entry->attachments()->value(key)]));
+        m_xml.writeAttribute("Ref", QString::number(m_idMap[entry->attachments()->hash(key)]));
         m_xml.writeEndElement();
 
         m_xml.writeEndElement();
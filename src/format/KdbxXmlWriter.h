@@ -85,7 +85,9 @@ private:
     QPointer<const Database> m_db;
     QPointer<const Metadata> m_meta;
     KeePass2RandomStream* m_randomStream = nullptr;
+    // Attachment hash to binary id
     QHash<QByteArray, int> m_idMap;
+    QList<QByteArray> m_binaries;
     QByteArray m_headerHash;
 
     bool m_error = false;
@@ -20,6 +20,31 @@
 #include "crypto/CryptoHash.h"
 #include "format/KeePass2.h"
 
+#include <cstring>
+
+namespace
+{
+    // Keystream generated per cipher call for the many short protected values
+    const int KEYSTREAM_BUFFER_SIZE = 4096;
+
+    void xorKeystream(char* data, const char* keystream, int size)
+    {
+        // Work on machine words, the compiler widens this loop to SIMD registers
+        int i = 0;
+        for (; i + 8 <= size; i += 8) {
+            quint64 block;
+            quint64 key;
+            std::memcpy(&block, data + i, sizeof(block));
+            std::memcpy(&key, keystream + i, sizeof(key));
+            block ^= key;
+            std::memcpy(data + i, &block, sizeof(block));
+        }
+        for (; i < size; ++i) {
+            data[i] ^= keystream[i];
+        }
+    }
+} // namespace
+
 bool KeePass2RandomStream::init(SymmetricCipher::Mode mode, const QByteArray& key)
 {
     switch (mode) {
@@ -42,22 +67,11 @@ bool KeePass2RandomStream::init(SymmetricCipher::Mode mode, const QByteArray& ke
 
 QByteArray KeePass2RandomStream::randomBytes(int size, bool* ok)
 {
-    QByteArray result;
-
-    int bytesRemaining = size;
-
-    while (bytesRemaining > 0) {
-        if (m_buffer.size() == m_offset) {
-            if (!loadBlock()) {
-                *ok = false;
-                return QByteArray();
-            }
-        }
-
-        int bytesToCopy = qMin(bytesRemaining, m_buffer.size() - m_offset);
-        result.append(m_buffer.mid(m_offset, bytesToCopy));
-        m_offset += bytesToCopy;
-        bytesRemaining -= bytesToCopy;
+    // XOR-ing zeros yields the keystream itself
+    QByteArray result(size, '\0');
+    if (!processInPlace(result.data(), size)) {
+        *ok = false;
+        return QByteArray();
     }
 
     *ok = true;
@@ -66,35 +80,37 @@ QByteArray KeePass2RandomStream::randomBytes(int size, bool* ok)
 
 QByteArray KeePass2RandomStream::process(const QByteArray& data, bool* ok)
 {
-    bool randomBytesOk;
-
-    QByteArray randomData = randomBytes(data.size(), &randomBytesOk);
-    if (!randomBytesOk) {
-        *ok = false;
+    QByteArray result = data;
+    *ok = processInPlace(result);
+    if (!*ok) {
         return QByteArray();
     }
-
-    QByteArray result;
-    result.resize(data.size());
-
-    for (int i = 0; i < data.size(); i++) {
-        result[i] = data[i] ^ randomData[i];
-    }
-
-    *ok = true;
     return result;
 }
 
 bool KeePass2RandomStream::processInPlace(QByteArray& data)
 {
-    bool ok;
-    QByteArray randomData = randomBytes(data.size(), &ok);
-    if (!ok) {
-        return false;
-    }
+    return processInPlace(data.data(), data.size());
+}
 
-    for (int i = 0; i < data.size(); i++) {
-        data[i] = data[i] ^ randomData[i];
+bool KeePass2RandomStream::processInPlace(char* data, int size)
+{
+    // Use up the keystream left over from the previous call first
+    const int buffered = qMin(size, m_buffer.size() - m_offset);
+    xorKeystream(data, m_buffer.constData() + m_offset, buffered);
+    m_offset += buffered;
+    data += buffered;
+    size -= buffered;
+
+    if (size >= KEYSTREAM_BUFFER_SIZE) {
+        // Large values are passed to the cipher as a whole, which applies the keystream in bulk
+        return m_cipher.process(data, size);
+    } else if (size > 0) {
+        if (!loadBlock()) {
+            return false;
+        }
+        xorKeystream(data, m_buffer.constData(), size);
+        m_offset = size;
     }
 
     return true;
@@ -109,7 +125,7 @@ bool KeePass2RandomStream::loadBlock()
 {
     Q_ASSERT(m_offset == m_buffer.size());
 
-    m_buffer.fill('\0', m_cipher.blockSize(m_cipher.mode()));
+    m_buffer.fill('\0', KEYSTREAM_BUFFER_SIZE);
     if (!m_cipher.process(m_buffer)) {
         return false;
     }
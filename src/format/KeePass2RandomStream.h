@@ -29,6 +29,7 @@ public:
     QByteArray randomBytes(int size, bool* ok);
     QByteArray process(const QByteArray& data, bool* ok);
     Q_REQUIRED_RESULT bool processInPlace(QByteArray& data);
+    Q_REQUIRED_RESULT bool processInPlace(char* data, int size);
     QString errorString() const;
 
 private:
@@ -29,6 +29,7 @@
 #include "gui/Icons.h"
 #include "gui/MainWindow.h"
 #include "gui/osutils/OSUtils.h"
+#include "keys/DerivedKeyCache.h"
 
 #include "FileDialog.h"
 #include "MessageBox.h"
@@ -132,6 +133,8 @@ ApplicationSettingsWidget::ApplicationSettingsWidget(QWidget* parent)
             m_secUi->clearSearchSpinBox, SLOT(setEnabled(bool)));
     connect(m_secUi->lockDatabaseIdleCheckBox, SIGNAL(toggled(bool)),
             m_secUi->lockDatabaseIdleSpinBox, SLOT(setEnabled(bool)));
+    connect(m_secUi->derivedKeyCacheCheckBox, SIGNAL(toggled(bool)),
+            m_secUi->derivedKeyCacheSpinBox, SLOT(setEnabled(bool)));
     // clang-format on
 
     // Disable mouse wheel grab when scrolling
@@ -295,6 +298,8 @@ void ApplicationSettingsWidget::loadSettings()
 
     m_secUi->lockDatabaseIdleCheckBox->setChecked(config()->get(Config::Security_LockDatabaseIdle).toBool());
     m_secUi->lockDatabaseIdleSpinBox->setValue(config()->get(Config::Security_LockDatabaseIdleSeconds).toInt());
+    m_secUi->derivedKeyCacheCheckBox->setChecked(config()->get(Config::Security_DerivedKeyCache).toBool());
+    m_secUi->derivedKeyCacheSpinBox->setValue(config()->get(Config::Security_DerivedKeyCacheTimeout).toInt());
     m_secUi->lockDatabaseMinimizeCheckBox->setChecked(config()->get(Config::Security_LockDatabaseMinimize).toBool());
     m_secUi->lockDatabaseOnScreenLockCheckBox->setChecked(
         config()->get(Config::Security_LockDatabaseScreenLock).toBool());
@@ -407,6 +412,8 @@ void ApplicationSettingsWidget::saveSettings()
 
     config()->set(Config::Security_LockDatabaseIdle, m_secUi->lockDatabaseIdleCheckBox->isChecked());
     config()->set(Config::Security_LockDatabaseIdleSeconds, m_secUi->lockDatabaseIdleSpinBox->value());
+    config()->set(Config::Security_DerivedKeyCache, m_secUi->derivedKeyCacheCheckBox->isChecked());
+    config()->set(Config::Security_DerivedKeyCacheTimeout, m_secUi->derivedKeyCacheSpinBox->value());
     config()->set(Config::Security_LockDatabaseMinimize, m_secUi->lockDatabaseMinimizeCheckBox->isChecked());
     config()->set(Config::Security_LockDatabaseScreenLock, m_secUi->lockDatabaseOnScreenLockCheckBox->isChecked());
     config()->set(Config::Security_IconDownloadFallback, m_secUi->fallbackToSearch->isChecked());
@@ -436,6 +443,10 @@ void ApplicationSettingsWidget::saveSettings()
         config()->remove(Config::LastChallengeResponse);
     }
 
+    if (!config()->get(Config::Security_DerivedKeyCache).toBool()) {
+        derivedKeyCache()->reset();
+    }
+
     for (const ExtraPage& page : asConst(m_extraPages)) {
         page.saveSettings();
     }
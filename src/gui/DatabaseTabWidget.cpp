@@ -35,6 +35,7 @@
 #include "gui/osutils/macutils/MacUtils.h"
 #endif
 #include "gui/wizard/NewDatabaseWizard.h"
+#include "keys/DerivedKeyCache.h"
 
 DatabaseTabWidget::DatabaseTabWidget(QWidget* parent)
     : QTabWidget(parent)
@@ -371,6 +372,7 @@ bool DatabaseTabWidget::closeDatabaseTab(DatabaseWidget* dbWidget)
         return false;
     }
 
+    derivedKeyCache()->reset(filePath);
     removeTab(tabIndex);
     dbWidget->deleteLater();
     toggleTabbar();
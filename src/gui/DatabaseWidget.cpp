@@ -38,6 +38,7 @@
 #include "gui/EntryPreviewWidget.h"
 #include "gui/FileDialog.h"
 #include "gui/GuiTools.h"
+#include "gui/Icons.h"
 #include "gui/KeePass1OpenWidget.h"
 #include "gui/MainWindow.h"
 #include "gui/MessageBox.h"
@@ -52,6 +53,7 @@
 #include "gui/reports/ReportsDialog.h"
 #include "gui/tag/TagModel.h"
 #include "keeshare/KeeShare.h"
+#include "keys/DerivedKeyCache.h"
 
 #ifdef WITH_XC_NETWORKING
 #include "gui/IconDownloaderDialog.h"
@@ -235,6 +237,10 @@ DatabaseWidget::DatabaseWidget(QSharedPointer<Database> db, QWidget* parent)
     m_blockAutoSave = false;
 
     m_searchLimitGroup = config()->get(Config::SearchLimitGroup).toBool();
+    // The search blocks until all ranges are matched, so the database cannot change meanwhile
+    m_entrySearcher->setParallel(true);
+    // Every keystroke searches again, so the search index pays off
+    m_entrySearcher->setIndexed(true);
 
 #ifdef WITH_XC_KEESHARE
     // We need to reregister the database to allow exports
@@ -430,6 +436,7 @@ void DatabaseWidget::replaceDatabase(QSharedPointer<Database> db)
     auto oldDb = m_db;
     m_db = std::move(db);
     connectDatabaseSignals();
+    Icons::preloadCustomIcons(m_db.data());
     m_groupView->changeDatabase(m_db);
     auto tagModel = new TagModel(m_db);
     m_tagView->setModel(tagModel);
@@ -1695,6 +1702,11 @@ bool DatabaseWidget::lock()
     sshAgent()->databaseLocked(m_db);
 #endif
 
+    // Keep the transformed key around to unlock without the KDF within the configured window
+    if (DerivedKeyCache::isEnabled() && m_db->key()) {
+        derivedKeyCache()->storeKey(m_db->filePath(), *m_db->key(), *m_db->kdf(), m_db->transformedDatabaseKey());
+    }
+
     endSearch();
     clearAllWidgets();
     switchToOpenDatabase(m_db->filePath());
@@ -19,6 +19,7 @@
 
 #include <QBuffer>
 #include <QFile>
+#include <QTextStream>
 
 #include "core/Group.h"
 #include "core/Metadata.h"
@@ -173,18 +174,18 @@ bool HtmlExporter::exportDatabase(QIODevice* device,
     const auto footer = QString("</body>"
                                 "</html>");
 
-    if (device->write(header.toUtf8()) == -1) {
-        m_error = device->errorString();
-        return false;
-    }
+    // Everything is written through the buffer of the stream as the groups are walked
+    QTextStream stream(device);
+    stream.setCodec("UTF-8");
 
+    stream << header;
     if (db->rootGroup()) {
-        if (!writeGroup(*device, *db->rootGroup(), QString(), sorted, ascending)) {
-            return false;
-        }
+        writeGroup(stream, *db->rootGroup(), QString(), sorted, ascending);
     }
+    stream << footer;
+    stream.flush();
 
-    if (device->write(footer.toUtf8()) == -1) {
+    if (stream.status() != QTextStream::Ok) {
         m_error = device->errorString();
         return false;
     }
@@ -192,7 +193,7 @@ bool HtmlExporter::exportDatabase(QIODevice* device,
     return true;
 }
 
-bool HtmlExporter::writeGroup(QIODevice& device, const Group& group, QString path, bool sorted, bool ascending)
+bool HtmlExporter::writeGroup(QTextStream& stream, const Group& group, QString path, bool sorted, bool ascending)
 {
     // Don't output the recycle bin
     if (&group == group.database()->metadata()->recycleBin()) {
@@ -224,14 +225,11 @@ bool HtmlExporter::writeGroup(QIODevice& device, const Group& group, QString pat
         }
 
         // Output it
-        if (device.write(header.toUtf8()) == -1) {
-            m_error = device.errorString();
-            return false;
-        }
+        stream << header;
     }
 
     // Begin the table for the entries in this group
-    auto table = QString("<table width=\"100%\">");
+    stream << "<table width=\"100%\">";
 
     auto entries = group.entries();
     if (sorted) {
@@ -250,19 +248,20 @@ bool HtmlExporter::writeGroup(QIODevice& device, const Group& group, QString pat
 
         // Output it into our table. First the left side with
         // icon and entry title ...
-        table += "<tr>";
-        table += "<td width=\"1%\">" + PixmapToHTML(Icons::entryIconPixmap(entry, IconSize::Medium)) + "</td>";
-        table += "<td width=\"19%\" valign=\"top\"><h3>" + entry->title().toHtmlEscaped() + "</h3></td>";
+        stream << "<tr>";
+        stream << "<td width=\"1%\">" << PixmapToHTML(Icons::entryIconPixmap(entry, IconSize::Medium)) << "</td>";
+        stream << "<td width=\"19%\" valign=\"top\"><h3>" << entry->title().toHtmlEscaped() << "</h3></td>";
 
         // ... then the right side with the data fields
-        table += "<td style=\"padding-bottom: 0.5em;\"><table width=\"100%\">" + formatted_entry + "</table></td>";
-        table += "</tr>";
+        stream << "<td style=\"padding-bottom: 0.5em;\"><table width=\"100%\">" << formatted_entry << "</table></td>";
+        stream << "</tr>";
     }
 
-    // Output the complete table of this group
-    table.append("</table>\n");
-    if (device.write(table.toUtf8()) == -1) {
-        m_error = device.errorString();
+    // Close the table of this group
+    stream << "</table>\n";
+
+    // Stop early once the device failed
+    if (stream.status() != QTextStream::Ok) {
         return false;
     }
 
@@ -276,7 +275,7 @@ bool HtmlExporter::writeGroup(QIODevice& device, const Group& group, QString pat
 
     // Recursively output the child groups
     for (const auto* child : children) {
-        if (child && !writeGroup(device, *child, path, sorted, ascending)) {
+        if (child && !writeGroup(stream, *child, path, sorted, ascending)) {
             return false;
         }
     }
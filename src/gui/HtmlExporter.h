@@ -24,6 +24,7 @@
 class Database;
 class Group;
 class QIODevice;
+class QTextStream;
 
 class HtmlExporter
 {
@@ -39,7 +40,7 @@ private:
                         const QSharedPointer<const Database>& db,
                         bool sorted = true,
                         bool ascending = true);
-    bool writeGroup(QIODevice& device,
+    bool writeGroup(QTextStream& stream,
                     const Group& group,
                     QString path = QString(),
                     bool sorted = true,
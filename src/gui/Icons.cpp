@@ -18,13 +18,16 @@
 
 #include "Icons.h"
 
+#include <QFutureWatcher>
 #include <QIconEngine>
 #include <QImageReader>
 #include <QPaintDevice>
 #include <QPainter>
+#include <QtConcurrent>
 
 #include "config-keepassx.h"
 #include "core/Config.h"
+#include "core/Metadata.h"
 #include "gui/DatabaseIcons.h"
 #include "gui/MainWindow.h"
 #include "gui/osutils/OSUtils.h"
@@ -46,6 +49,137 @@ private:
     QColor m_overrideColor;
 };
 
+namespace
+{
+    // Custom icons are scaled to this size once, smaller sizes are derived from it
+    const int CustomIconBaseSize = 64;
+
+    QImage decodeCustomIcon(const QByteArray& data)
+    {
+        auto image = QImage::fromData(data);
+        return image.scaled(CustomIconBaseSize, CustomIconBaseSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    /**
+     * Decoded custom icons of a database, kept for as long as its metadata
+     * exists. Icons are dropped as soon as the metadata adds or removes them.
+     * Badges are cached separately by DatabaseIcons::applyBadge() based on
+     * the cache key of the pixmaps handed out here.
+     */
+    class CustomIconCache : public QObject
+    {
+    public:
+        explicit CustomIconCache(const Metadata* metadata);
+
+        QPixmap pixmap(const QUuid& uuid, IconSize size);
+        void preload();
+
+    private:
+        void invalidate(const QUuid& uuid);
+
+        const Metadata* m_metadata;
+        QHash<QUuid, QImage> m_images;
+        QHash<QPair<QUuid, int>, QPixmap> m_pixmaps;
+        QFutureWatcher<QHash<QUuid, QImage>> m_preloadWatcher;
+        int m_generation = 0;
+    };
+
+    QHash<const Metadata*, CustomIconCache*> customIconCaches;
+
+    CustomIconCache* customIconCache(const Metadata* metadata)
+    {
+        auto cache = customIconCaches.value(metadata);
+        if (!cache) {
+            cache = new CustomIconCache(metadata);
+            customIconCaches.insert(metadata, cache);
+        }
+        return cache;
+    }
+
+    CustomIconCache::CustomIconCache(const Metadata* metadata)
+        : m_metadata(metadata)
+    {
+        connect(metadata, &Metadata::customIconChanged, this, &CustomIconCache::invalidate);
+        connect(metadata, &QObject::destroyed, this, [this] {
+            // Forget the cache right away, a new database may reuse the address of the metadata
+            customIconCaches.remove(m_metadata);
+            m_metadata = nullptr;
+            deleteLater();
+        });
+        connect(&m_preloadWatcher, &QFutureWatcherBase::finished, this, [this] {
+            const auto images = m_preloadWatcher.result();
+            if (!m_metadata || m_preloadWatcher.property("generation").toInt() != m_generation) {
+                return;
+            }
+            for (auto it = images.constBegin(); it != images.constEnd(); ++it) {
+                if (!m_images.contains(it.key())) {
+                    m_images.insert(it.key(), it.value());
+                }
+            }
+        });
+    }
+
+    QPixmap CustomIconCache::pixmap(const QUuid& uuid, IconSize size)
+    {
+        const auto key = qMakePair(uuid, static_cast<int>(size));
+        auto pixmap = m_pixmaps.value(key);
+        if (pixmap.isNull()) {
+            if (!m_images.contains(uuid)) {
+                m_images.insert(uuid, decodeCustomIcon(m_metadata->customIcon(uuid).data));
+            }
+            // Generate QIcon with pre-baked resolutions
+            auto basePixmap = QPixmap::fromImage(m_images.value(uuid));
+            pixmap = QIcon(basePixmap).pixmap(databaseIcons()->iconSize(size));
+            m_pixmaps.insert(key, pixmap);
+        }
+        return pixmap;
+    }
+
+    /**
+     * Decodes all icons that are not decoded yet on a worker thread.
+     * Only the raw icon data is handed to it, the results are merged on
+     * this thread unless icons changed in the meantime.
+     */
+    void CustomIconCache::preload()
+    {
+        if (!m_metadata || m_preloadWatcher.isRunning()) {
+            return;
+        }
+
+        QList<QPair<QUuid, QByteArray>> icons;
+        for (const QUuid& uuid : m_metadata->customIconsOrder()) {
+            if (!m_images.contains(uuid)) {
+                icons.append({uuid, m_metadata->customIcon(uuid).data});
+            }
+        }
+        if (icons.isEmpty()) {
+            return;
+        }
+
+        m_preloadWatcher.setProperty("generation", m_generation);
+        m_preloadWatcher.setFuture(QtConcurrent::run([icons] {
+            QHash<QUuid, QImage> images;
+            for (const auto& icon : icons) {
+                images.insert(icon.first, decodeCustomIcon(icon.second));
+            }
+            return images;
+        }));
+    }
+
+    void CustomIconCache::invalidate(const QUuid& uuid)
+    {
+        ++m_generation;
+        m_images.remove(uuid);
+        for (auto it = m_pixmaps.begin(); it != m_pixmaps.end();) {
+            if (it.key().first == uuid) {
+                it = m_pixmaps.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+} // namespace
+
 Icons* Icons::m_instance(nullptr);
 
 Icons::Icons()
@@ -235,10 +369,18 @@ QPixmap Icons::customIconPixmap(const Database* db, const QUuid& uuid, IconSize
     if (!db->metadata()->hasCustomIcon(uuid)) {
         return {};
     }
-    // Generate QIcon with pre-baked resolutions
-    auto icon = QImage::fromData(db->metadata()->customIcon(uuid).data);
-    auto basePixmap = QPixmap::fromImage(icon.scaled(64, 64, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
-    return QIcon(basePixmap).pixmap(databaseIcons()->iconSize(size));
+    return customIconCache(db->metadata())->pixmap(uuid, size);
+}
+
+/**
+ * Decodes the custom icons of a database in the background, so they do
+ * not have to be decoded while the views are painted for the first time.
+ */
+void Icons::preloadCustomIcons(const Database* db)
+{
+    if (db && db->metadata()) {
+        customIconCache(db->metadata())->preload();
+    }
 }
 
 QHash<QUuid, QPixmap> Icons::customIconsPixmaps(const Database* db, IconSize size)
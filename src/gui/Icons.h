@@ -40,6 +40,7 @@ public:
     static QHash<QUuid, QPixmap> customIconsPixmaps(const Database* db, IconSize size = IconSize::Default);
     static QPixmap entryIconPixmap(const Entry* entry, IconSize size = IconSize::Default);
     static QPixmap groupIconPixmap(const Group* group, IconSize size = IconSize::Default);
+    static void preloadCustomIcons(const Database* db);
 
     static QByteArray saveToBytes(const QImage& image);
     static QString imageFormatsFilter();
@@ -23,6 +23,7 @@
 #include "gui/databasekey/PasswordEditWidget.h"
 #include "gui/databasekey/YubiKeyEditWidget.h"
 #include "keys/ChallengeResponseKey.h"
+#include "keys/DerivedKeyCache.h"
 #include "keys/FileKey.h"
 #include "keys/PasswordKey.h"
 
@@ -205,6 +206,7 @@ bool DatabaseSettingsWidgetDatabaseKey::save()
 #elif defined(Q_CC_MSVC)
     getWindowsHello()->reset(m_db->filePath());
 #endif
+    derivedKeyCache()->reset(m_db->filePath());
 
     emit editFinished(true);
     if (m_isDirty) {
@@ -36,6 +36,7 @@ DatabaseSettingsWidgetEncryption::DatabaseSettingsWidgetEncryption(QWidget* pare
     m_ui->setupUi(this);
 
     connect(m_ui->transformBenchmarkButton, SIGNAL(clicked()), SLOT(benchmarkTransformRounds()));
+    connect(m_ui->transformCalibrateButton, SIGNAL(clicked()), SLOT(calibrateKdfParameters()));
     connect(m_ui->kdfComboBox, SIGNAL(currentIndexChanged(int)), SLOT(changeKdf(int)));
     m_ui->formatCannotBeChanged->setVisible(false);
 
@@ -52,6 +53,9 @@ DatabaseSettingsWidgetEncryption::DatabaseSettingsWidgetEncryption(QWidget* pare
     m_ui->transformBenchmarkButton->setText(
         QObject::tr("Benchmark %1 delay")
             .arg(DatabaseSettingsWidgetEncryption::getTextualEncryptionTime(Kdf::DEFAULT_ENCRYPTION_TIME)));
+    m_ui->transformCalibrateButton->setText(
+        QObject::tr("Calibrate %1 delay")
+            .arg(DatabaseSettingsWidgetEncryption::getTextualEncryptionTime(Kdf::DEFAULT_ENCRYPTION_TIME)));
     m_ui->minTimeLabel->setText(DatabaseSettingsWidgetEncryption::getTextualEncryptionTime(Kdf::MIN_ENCRYPTION_TIME));
     m_ui->maxTimeLabel->setText(DatabaseSettingsWidgetEncryption::getTextualEncryptionTime(Kdf::MAX_ENCRYPTION_TIME));
 
@@ -202,6 +206,7 @@ void DatabaseSettingsWidgetEncryption::updateKdfFields()
     m_ui->memorySpinBox->setVisible(IS_ARGON2(id));
     m_ui->parallelismLabel->setVisible(IS_ARGON2(id));
     m_ui->parallelismSpinBox->setVisible(IS_ARGON2(id));
+    m_ui->transformCalibrateButton->setVisible(IS_ARGON2(id));
 }
 
 void DatabaseSettingsWidgetEncryption::activateChangeDecryptionTime()
@@ -344,6 +349,34 @@ void DatabaseSettingsWidgetEncryption::benchmarkTransformRounds(int millisecs)
     QApplication::restoreOverrideCursor();
 }
 
+/**
+ * Fill in the Argon2 memory usage, rounds and parallelism that make the most
+ * of the given delay on this computer.
+ */
+void DatabaseSettingsWidgetEncryption::calibrateKdfParameters(int millisecs)
+{
+    auto kdf = KeePass2::uuidToKdf(QUuid(m_ui->kdfComboBox->currentData().toByteArray()));
+    if (!IS_ARGON2(kdf->uuid())) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::BusyCursor);
+    m_ui->transformCalibrateButton->setEnabled(false);
+    m_ui->transformRoundsSpinBox->setFocus();
+
+    auto argon2Kdf = kdf.staticCast<Argon2Kdf>();
+    bool ok = AsyncTask::runAndWaitForFuture([&argon2Kdf, millisecs]() { return argon2Kdf->calibrate(millisecs); });
+
+    if (ok) {
+        m_ui->transformRoundsSpinBox->setValue(argon2Kdf->rounds());
+        m_ui->memorySpinBox->setValue(static_cast<int>(argon2Kdf->memory() / (1 << 10)));
+        m_ui->parallelismSpinBox->setValue(static_cast<int>(argon2Kdf->parallelism()));
+        m_ui->decryptionTimeSlider->setValue(millisecs / 100);
+    }
+    m_ui->transformCalibrateButton->setEnabled(true);
+    QApplication::restoreOverrideCursor();
+}
+
 void DatabaseSettingsWidgetEncryption::changeKdf(int index)
 {
     Q_ASSERT(m_db);
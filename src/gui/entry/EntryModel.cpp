@@ -147,7 +147,7 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
             }
             break;
         case Title:
-            result = entry->resolveMultiplePlaceholders(entry->title());
+            result = entry->resolvedTitle();
             if (attr->isReference(EntryAttributes::TitleKey)) {
                 result.prepend(tr("Ref: ", "Reference abbreviation"));
             }
@@ -156,7 +156,7 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
             if (config()->get(Config::GUI_HideUsernames).toBool()) {
                 result = EntryModel::HiddenContentDisplay;
             } else {
-                result = entry->resolveMultiplePlaceholders(entry->username());
+                result = entry->resolvedUsername();
             }
             if (attr->isReference(EntryAttributes::UserNameKey)) {
                 result.prepend(tr("Ref: ", "Reference abbreviation"));
@@ -169,7 +169,7 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
             if (config()->get(Config::GUI_HidePasswords).toBool()) {
                 result = EntryModel::HiddenContentDisplay;
             } else {
-                result = entry->resolveMultiplePlaceholders(entry->password());
+                result = entry->resolvedPassword();
             }
             if (attr->isReference(EntryAttributes::PasswordKey)) {
                 result.prepend(tr("Ref: ", "Reference abbreviation"));
@@ -244,9 +244,9 @@ QVariant EntryModel::data(const QModelIndex& index, int role) const
     } else if (role == Qt::UserRole) { // Qt::UserRole is used as sort role, see EntryView::EntryView()
         switch (index.column()) {
         case Username:
-            return entry->resolveMultiplePlaceholders(entry->username());
+            return entry->resolvedUsername();
         case Password:
-            return entry->resolveMultiplePlaceholders(entry->password());
+            return entry->resolvedPassword();
         case PasswordStrength: {
             if (!entry->password().isEmpty() && !entry->excludeFromReports()) {
                 return entry->passwordHealth()->score();
@@ -22,12 +22,24 @@
 #include "crypto/kdf/Kdf.h"
 #include "format/KeePass2.h"
 #include "keys/ChallengeResponseKey.h"
+#include "keys/DerivedKeyCache.h"
 #include "keys/FileKey.h"
 #include "keys/PasswordKey.h"
 
 #include <QDataStream>
 #include <QDebug>
 
+namespace
+{
+    bool transformRawKey(const Kdf& kdf, const QByteArray& rawKey, QByteArray& result)
+    {
+        if (derivedKeyCache()->getKey(kdf, rawKey, result)) {
+            return true;
+        }
+        return kdf.transform(rawKey, result);
+    }
+} // namespace
+
 QUuid CompositeKey::UUID("76a7ae25-a542-4add-9849-7c06be945b94");
 
 CompositeKey::CompositeKey()
@@ -114,6 +126,9 @@ QByteArray CompositeKey::rawKey(const QByteArray* transformSeed, bool* ok, QStri
  * challenge response key components after key transformation.
  * KDBX4+ KDFs transform the whole key including challenge-response components.
  *
+ * A key cached by DerivedKeyCache when the database was locked is used
+ * instead of running the KDF if the composite key matches.
+ *
  * @param kdf key derivation function
  * @param result transformed key hash
  * @return true on success
@@ -122,13 +137,13 @@ bool CompositeKey::transform(const Kdf& kdf, QByteArray& result, QString* error)
 {
     if (kdf.uuid() == KeePass2::KDF_AES_KDBX3) {
         // legacy KDBX3 AES-KDF, challenge response is added later to the hash
-        return kdf.transform(rawKey(), result);
+        return transformRawKey(kdf, rawKey(), result);
     }
 
     QByteArray seed = kdf.seed();
     Q_ASSERT(!seed.isEmpty());
     bool ok = false;
-    return kdf.transform(rawKey(&seed, &ok, error), result) && ok;
+    return transformRawKey(kdf, rawKey(&seed, &ok, error), result) && ok;
 }
 
 bool CompositeKey::challenge(const QByteArray& seed, QByteArray& result, QString* error) const
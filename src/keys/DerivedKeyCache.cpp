@@ -0,0 +1,218 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DerivedKeyCache.h"
+
+#include "core/Config.h"
+#include "core/Global.h"
+#include "crypto/CryptoHash.h"
+#include "crypto/Random.h"
+#include "crypto/kdf/Kdf.h"
+#include "keys/CompositeKey.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+
+#include <botan/mem_ops.h>
+
+namespace
+{
+    const int SessionKeySize = 32;
+    const int WrappedKeySize = 32;
+
+    QByteArray toByteArray(const Botan::secure_vector<uint8_t>& data)
+    {
+        return QByteArray(reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size()));
+    }
+} // namespace
+
+DerivedKeyCache* DerivedKeyCache::instance()
+{
+    static auto* cache = new DerivedKeyCache();
+    return cache;
+}
+
+DerivedKeyCache::DerivedKeyCache(QObject* parent)
+    : QObject(parent)
+    , m_expiryTimer(this)
+{
+    // The cache may first be used from a key transformation running in a worker thread
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    m_expiryTimer.setSingleShot(true);
+    connect(&m_expiryTimer, &QTimer::timeout, this, &DerivedKeyCache::removeExpiredKeys);
+}
+
+bool DerivedKeyCache::isEnabled()
+{
+    return config()->get(Config::Security_DerivedKeyCache).toBool();
+}
+
+/**
+ * Cache the transformed key of a database that is being locked. Keys with
+ * challenge-response components are not cached, their challenge has to be
+ * answered on every unlock anyway.
+ *
+ * @param dbPath path of the database
+ * @param key composite key the database was unlocked with
+ * @param kdf key derivation function of the database
+ * @param transformedKey result of transforming key with kdf
+ * @return true if the key was cached
+ */
+bool DerivedKeyCache::storeKey(const QString& dbPath,
+                               const CompositeKey& key,
+                               const Kdf& kdf,
+                               const QByteArray& transformedKey)
+{
+    if (!isEnabled() || !key.challengeResponseKeys().isEmpty() || transformedKey.size() != WrappedKeySize) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_sessionKey.empty()) {
+        m_sessionKey.resize(SessionKeySize);
+        randomGen()->getRng()->randomize(m_sessionKey.data(), m_sessionKey.size());
+    }
+
+    const QByteArray rawKey = key.rawKey();
+    const QByteArray id = deriveKey("id", kdf, rawKey);
+    const QByteArray wrappingKey = deriveKey("wrap", kdf, rawKey);
+
+    CachedKey cachedKey;
+    cachedKey.id.assign(id.cbegin(), id.cend());
+    cachedKey.wrappedKey.resize(WrappedKeySize);
+    for (int i = 0; i < WrappedKeySize; ++i) {
+        cachedKey.wrappedKey[i] = static_cast<uint8_t>(transformedKey[i] ^ wrappingKey[i]);
+    }
+
+    const int timeout = config()->get(Config::Security_DerivedKeyCacheTimeout).toInt() * 60 * 1000;
+    cachedKey.expiry = QDateTime::currentMSecsSinceEpoch() + timeout;
+
+    m_keys.insert(dbPath, cachedKey);
+    if (!m_expiryTimer.isActive() || m_expiryTimer.remainingTime() > timeout) {
+        m_expiryTimer.start(timeout);
+    }
+    return true;
+}
+
+/**
+ * Look up the transformed key for a raw composite key. A cached key is
+ * handed out only once, locking the database again caches it anew.
+ *
+ * @param kdf key derivation function that is about to be run
+ * @param rawKey raw composite key that is about to be transformed
+ * @param transformedKey receives the cached transformed key
+ * @return true if a cached key was found
+ */
+bool DerivedKeyCache::getKey(const Kdf& kdf, const QByteArray& rawKey, QByteArray& transformedKey)
+{
+    QMutexLocker locker(&m_mutex);
+    purgeExpiredKeys(QDateTime::currentMSecsSinceEpoch());
+    if (m_keys.isEmpty()) {
+        return false;
+    }
+
+    const QByteArray id = deriveKey("id", kdf, rawKey);
+    for (auto it = m_keys.begin(); it != m_keys.end(); ++it) {
+        const auto& cachedId = it->id;
+        if (cachedId.size() != static_cast<size_t>(id.size())
+            || !Botan::same_mem(cachedId.data(), reinterpret_cast<const uint8_t*>(id.constData()), cachedId.size())) {
+            continue;
+        }
+
+        const QByteArray wrappingKey = deriveKey("wrap", kdf, rawKey);
+        transformedKey.resize(WrappedKeySize);
+        for (int i = 0; i < WrappedKeySize; ++i) {
+            transformedKey[i] = static_cast<char>(it->wrappedKey[i] ^ static_cast<uint8_t>(wrappingKey[i]));
+        }
+        m_keys.erase(it);
+        return true;
+    }
+
+    return false;
+}
+
+bool DerivedKeyCache::hasKey(const QString& dbPath) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_keys.constFind(dbPath);
+    return it != m_keys.constEnd() && it->expiry > QDateTime::currentMSecsSinceEpoch();
+}
+
+void DerivedKeyCache::reset(const QString& dbPath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_keys.remove(dbPath);
+}
+
+void DerivedKeyCache::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_keys.clear();
+    m_expiryTimer.stop();
+}
+
+void DerivedKeyCache::removeExpiredKeys()
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    purgeExpiredKeys(now);
+
+    qint64 nextExpiry = 0;
+    for (const auto& cachedKey : asConst(m_keys)) {
+        if (nextExpiry == 0 || cachedKey.expiry < nextExpiry) {
+            nextExpiry = cachedKey.expiry;
+        }
+    }
+    if (nextExpiry != 0) {
+        m_expiryTimer.start(static_cast<int>(nextExpiry - now));
+    }
+}
+
+void DerivedKeyCache::purgeExpiredKeys(qint64 now)
+{
+    for (auto it = m_keys.begin(); it != m_keys.end();) {
+        if (it->expiry <= now) {
+            it = m_keys.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Keyed hash of the KDF parameters and the raw composite key. It depends on
+ * the transform seed, so a cached key never matches after the database was
+ * saved with new KDF settings.
+ */
+QByteArray DerivedKeyCache::deriveKey(const char* label, const Kdf& kdf, const QByteArray& rawKey) const
+{
+    CryptoHash hmac(CryptoHash::Sha256, true);
+    hmac.setKey(toByteArray(m_sessionKey));
+    hmac.addData(label);
+
+    const QVariantMap parameters = kdf.clone()->writeParameters();
+    for (auto it = parameters.constBegin(); it != parameters.constEnd(); ++it) {
+        hmac.addData(it.key().toUtf8());
+        hmac.addData(it.value().toByteArray());
+    }
+
+    hmac.addData(rawKey);
+    return hmac.result();
+}
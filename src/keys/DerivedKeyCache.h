@@ -0,0 +1,81 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_DERIVEDKEYCACHE_H
+#define KEEPASSXC_DERIVEDKEYCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+
+#include <botan/secmem.h>
+
+class CompositeKey;
+class Kdf;
+
+/**
+ * Keeps the transformed key of a locked database for a short time so that
+ * unlocking it again with the same credentials skips the key derivation.
+ *
+ * Cached keys are wrapped under a random per-session key and can only be
+ * found and unwrapped with the composite key they were derived from.
+ */
+class DerivedKeyCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DerivedKeyCache* instance();
+    static bool isEnabled();
+
+    bool storeKey(const QString& dbPath, const CompositeKey& key, const Kdf& kdf, const QByteArray& transformedKey);
+    bool getKey(const Kdf& kdf, const QByteArray& rawKey, QByteArray& transformedKey);
+    bool hasKey(const QString& dbPath) const;
+    void reset(const QString& dbPath);
+    void reset();
+
+private slots:
+    void removeExpiredKeys();
+
+private:
+    struct CachedKey
+    {
+        Botan::secure_vector<uint8_t> id;
+        Botan::secure_vector<uint8_t> wrappedKey;
+        qint64 expiry;
+    };
+
+    explicit DerivedKeyCache(QObject* parent = nullptr);
+    ~DerivedKeyCache() override = default;
+    Q_DISABLE_COPY(DerivedKeyCache);
+
+    QByteArray deriveKey(const char* label, const Kdf& kdf, const QByteArray& rawKey) const;
+    void purgeExpiredKeys(qint64 now);
+
+    Botan::secure_vector<uint8_t> m_sessionKey;
+    QHash<QString, CachedKey> m_keys;
+    QTimer m_expiryTimer;
+    mutable QMutex m_mutex;
+};
+
+inline DerivedKeyCache* derivedKeyCache()
+{
+    return DerivedKeyCache::instance();
+}
+
+#endif // KEEPASSXC_DERIVEDKEYCACHE_H
@@ -0,0 +1,422 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HmacDecryptStream.h"
+
+#include <QtConcurrent>
+
+#include "core/Endian.h"
+#include "crypto/CryptoHash.h"
+#include "streams/HmacBlockStream.h"
+
+#include <limits>
+#include <zlib.h>
+
+namespace
+{
+    // Upper bound of blocks read ahead, each of them is up to 1 MiB
+    const int MaxPendingBlocks = 16;
+} // namespace
+
+const QSysInfo::Endian HmacDecryptStream::ByteOrder = QSysInfo::LittleEndian;
+
+HmacDecryptStream::HmacDecryptStream(QIODevice* baseDevice, QByteArray hmacKey)
+    : LayeredStream(baseDevice)
+    , m_hmacKey(std::move(hmacKey))
+    , m_zstream(new z_stream())
+{
+    setMaxThreadCount(QThread::idealThreadCount());
+}
+
+HmacDecryptStream::~HmacDecryptStream()
+{
+    close();
+}
+
+bool HmacDecryptStream::init(SymmetricCipher::Mode mode,
+                             const QByteArray& key,
+                             const QByteArray& iv,
+                             bool compressed)
+{
+    // Catch an invalid key or IV up front instead of on every block
+    SymmetricCipher cipher;
+    m_isInitialized = cipher.init(mode, SymmetricCipher::Decrypt, key, iv);
+    if (!m_isInitialized) {
+        setErrorString(cipher.errorString());
+        return false;
+    }
+    m_mode = mode;
+    m_key = key;
+    m_iv = iv;
+    m_cipherBlockSize = SymmetricCipher::blockSize(mode);
+    m_compressed = compressed;
+    return true;
+}
+
+/**
+ * Number of threads verifying and decrypting blocks ahead of the reader,
+ * with a single thread everything is done on the reading thread.
+ */
+void HmacDecryptStream::setMaxThreadCount(int threads)
+{
+    threads = qMax(1, threads);
+    m_pool.setMaxThreadCount(threads);
+    m_maxPending = threads > 1 ? qMin(threads * 2, MaxPendingBlocks) : 1;
+}
+
+bool HmacDecryptStream::open(QIODevice::OpenMode mode)
+{
+    if (!m_isInitialized || (mode & QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    if (m_compressed) {
+        // Accept the gzip format only, same as QtIOCompressor::GzipFormat
+        if (inflateInit2(m_zstream.data(), MAX_WBITS + 16) != Z_OK) {
+            setErrorString(m_zstream->msg ? QString::fromLatin1(m_zstream->msg) : QString());
+            return false;
+        }
+    }
+
+    if (!LayeredStream::open(mode)) {
+        if (m_compressed) {
+            inflateEnd(m_zstream.data());
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void HmacDecryptStream::close()
+{
+    // Workers may still be decrypting blocks inside their buffers
+    m_pool.waitForDone();
+    m_pending.clear();
+    m_current.reset();
+    m_freeBuffers.clear();
+
+    if (isOpen() && m_compressed) {
+        inflateEnd(m_zstream.data());
+    }
+
+    m_data = nullptr;
+    m_dataSize = 0;
+    m_dataPos = 0;
+    m_carry.clear();
+
+    LayeredStream::close();
+}
+
+bool HmacDecryptStream::atEnd() const
+{
+    if (m_compressed) {
+        return m_inflateEnd;
+    }
+    return m_eof && m_dataPos == m_dataSize;
+}
+
+qint64 HmacDecryptStream::readData(char* data, qint64 maxSize)
+{
+    if (m_error) {
+        return -1;
+    } else if (m_compressed) {
+        return inflateData(data, maxSize);
+    }
+
+    qint64 bytesRemaining = maxSize;
+    qint64 offset = 0;
+
+    while (bytesRemaining > 0) {
+        if (m_dataPos == m_dataSize) {
+            if (!readBlock()) {
+                if (m_error) {
+                    return -1;
+                }
+                return maxSize - bytesRemaining;
+            }
+        }
+
+        qint64 bytesToCopy = qMin(bytesRemaining, static_cast<qint64>(m_dataSize - m_dataPos));
+
+        memcpy(data + offset, m_data + m_dataPos, static_cast<size_t>(bytesToCopy));
+
+        offset += bytesToCopy;
+        m_dataPos += bytesToCopy;
+        bytesRemaining -= bytesToCopy;
+    }
+
+    return maxSize;
+}
+
+qint64 HmacDecryptStream::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 HmacDecryptStream::inflateData(char* data, qint64 maxSize)
+{
+    if (m_inflateEnd) {
+        return 0;
+    }
+
+    maxSize = qMin(maxSize, static_cast<qint64>(std::numeric_limits<int>::max()));
+    m_zstream->next_out = reinterpret_cast<Bytef*>(data);
+    m_zstream->avail_out = static_cast<uInt>(maxSize);
+
+    while (m_zstream->avail_out > 0) {
+        if (m_dataPos == m_dataSize) {
+            if (!readBlock()) {
+                if (m_error) {
+                    return -1;
+                }
+                break;
+            }
+        }
+
+        // Inflate straight from the decrypted block, there is no intermediate buffer
+        m_zstream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(m_data + m_dataPos));
+        m_zstream->avail_in = static_cast<uInt>(m_dataSize - m_dataPos);
+        int status = inflate(m_zstream.data(), Z_NO_FLUSH);
+        m_dataPos = m_dataSize - static_cast<int>(m_zstream->avail_in);
+
+        if (status == Z_STREAM_END) {
+            m_inflateEnd = true;
+            break;
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+            raiseError(QString("Internal zlib error when decompressing: %1")
+                           .arg(m_zstream->msg ? QString::fromLatin1(m_zstream->msg) : QString::number(status)));
+            return -1;
+        }
+    }
+
+    return maxSize - m_zstream->avail_out;
+}
+
+bool HmacDecryptStream::readBlockHeader(QString& error)
+{
+    char sizeBytes[4];
+    if (m_baseDevice->read(m_blockHmac, 32) != 32 || m_baseDevice->read(sizeBytes, 4) != 4) {
+        error = "Invalid block header size.";
+        return false;
+    }
+
+    m_blockSize = Endian::bytesToSizedInt<qint32>(QByteArray::fromRawData(sizeBytes, 4), ByteOrder);
+    if (m_blockSize < 0) {
+        error = "Invalid block size.";
+        return false;
+    }
+
+    m_headerRead = true;
+    return true;
+}
+
+/**
+ * Makes the next decrypted block the current one, waiting for the
+ * worker that processes it if needed.
+ */
+bool HmacDecryptStream::readBlock()
+{
+    if (m_eof) {
+        return false;
+    }
+
+    if (m_current && !m_current->buffer.isNull()) {
+        m_freeBuffers.append(std::move(m_current->buffer));
+    }
+    m_current.reset();
+
+    fillPipeline();
+    if (m_pending.isEmpty()) {
+        m_eof = true;
+        return false;
+    }
+    m_current = m_pending.dequeue();
+    fillPipeline();
+
+    m_current->future.waitForFinished();
+    if (!m_current->error.isEmpty()) {
+        raiseError(m_current->error);
+        return false;
+    } else if (m_current->endOfStream) {
+        m_eof = true;
+        return false;
+    }
+
+    m_data = m_current->data;
+    m_dataSize = m_current->size;
+    m_dataPos = 0;
+    return m_dataSize > 0 || readBlock();
+}
+
+void HmacDecryptStream::fillPipeline()
+{
+    while (!m_fetchDone && m_pending.size() < m_maxPending) {
+        auto block = fetchBlock();
+        if (block->error.isEmpty()) {
+            if (m_maxPending > 1) {
+                block->future = QtConcurrent::run(&m_pool, [this, block] { processBlock(*block); });
+            } else {
+                processBlock(*block);
+            }
+        }
+        m_pending.enqueue(block);
+    }
+}
+
+/**
+ * Reads the next block from the base device and determines everything
+ * needed to decrypt it independently of the blocks before it.
+ */
+QSharedPointer<HmacDecryptStream::Block> HmacDecryptStream::fetchBlock()
+{
+    QSharedPointer<Block> block(new Block());
+    block->index = m_blockIndex++;
+
+    if (!m_headerRead && !readBlockHeader(block->error)) {
+        m_fetchDone = true;
+        return block;
+    }
+    m_headerRead = false;
+    block->hmac = QByteArray(m_blockHmac, 32);
+
+    const int size = m_blockSize;
+    if (size == 0) {
+        block->endOfStream = true;
+        m_fetchDone = true;
+        return block;
+    }
+
+    const int carry = m_carry.size();
+    if (size > std::numeric_limits<int>::max() - carry) {
+        block->error = "Invalid block size.";
+        m_fetchDone = true;
+        return block;
+    }
+    char* data = fetchData(*block, size);
+    if (!data) {
+        block->error = "Block too short.";
+        m_fetchDone = true;
+        return block;
+    }
+    block->hmacData = data;
+    block->hmacSize = size;
+    block->data = data - carry;
+    block->size = carry + size;
+
+    // Block ciphers have to remove the padding from the last block,
+    // so look ahead at the size of the next one
+    if (!readBlockHeader(block->error)) {
+        m_fetchDone = true;
+        return block;
+    }
+    block->lastBlock = m_blockSize == 0;
+
+    block->iv = m_iv;
+    if (m_cipherBlockSize > 1) {
+        // HMAC blocks do not need to be aligned to cipher blocks
+        const int remainder = block->lastBlock ? 0 : block->size % m_cipherBlockSize;
+        block->size -= remainder;
+        m_carry = QByteArray(block->data + block->size, remainder);
+        // CBC continues from the last cipher block, read it before it is decrypted
+        if (block->size >= m_cipherBlockSize) {
+            m_iv = QByteArray(block->data + block->size - m_cipherBlockSize, m_cipherBlockSize);
+        }
+    } else {
+        block->offset = m_streamOffset;
+        m_streamOffset += static_cast<quint64>(block->size);
+    }
+
+    return block;
+}
+
+/**
+ * Reads the data of the next block into the buffer of the block,
+ * preceded by the cipher text left over from the previous block.
+ */
+char* HmacDecryptStream::fetchData(Block& block, int size)
+{
+    const int carry = m_carry.size();
+    // The size comes from the file, do not allocate more than is left to read
+    if (!m_baseDevice->isSequential() && size > m_baseDevice->bytesAvailable()) {
+        return nullptr;
+    }
+
+    if (!m_freeBuffers.isEmpty()) {
+        block.buffer = m_freeBuffers.takeLast();
+    }
+    block.buffer.resize(carry + size);
+    if (block.buffer.size() != carry + size) {
+        return nullptr;
+    }
+    memcpy(block.buffer.data(), m_carry.constData(), static_cast<size_t>(carry));
+    char* data = block.buffer.data() + carry;
+
+    if (m_baseDevice->read(data, size) != size) {
+        return nullptr;
+    }
+    return data;
+}
+
+/**
+ * Verifies and decrypts a block, runs on the worker threads.
+ */
+void HmacDecryptStream::processBlock(Block& block) const
+{
+    CryptoHash hasher(CryptoHash::Sha256, true);
+    hasher.setKey(HmacBlockStream::getHmacKey(block.index, m_hmacKey));
+    hasher.addData(Endian::sizedIntToBytes<quint64>(block.index, ByteOrder));
+    hasher.addData(Endian::sizedIntToBytes<qint32>(block.hmacSize, ByteOrder));
+    hasher.addData(QByteArray::fromRawData(block.hmacData, block.hmacSize));
+
+    if (hasher.result() != block.hmac) {
+        block.error = "Mismatch between hash and data.";
+        return;
+    } else if (block.size == 0) {
+        return;
+    }
+
+    SymmetricCipher cipher;
+    bool ok = cipher.init(m_mode, SymmetricCipher::Decrypt, m_key, block.iv)
+              && (block.offset == 0 || cipher.seek(block.offset));
+
+    if (ok && m_cipherBlockSize > 1 && block.lastBlock) {
+        // Only the final cipher block has to go through finish(), its
+        // unpadded plain text is never longer than the cipher text
+        const int tailPos = qMax(0, block.size - m_cipherBlockSize);
+        QByteArray tail(block.data + tailPos, block.size - tailPos);
+        ok = (tailPos == 0 || cipher.process(block.data, tailPos)) && cipher.finish(tail);
+        if (ok) {
+            memcpy(block.data + tailPos, tail.constData(), static_cast<size_t>(tail.size()));
+            block.size = tailPos + tail.size();
+        }
+    } else if (ok) {
+        ok = cipher.process(block.data, block.size);
+    }
+
+    if (!ok) {
+        block.error = cipher.errorString();
+    }
+}
+
+void HmacDecryptStream::raiseError(const QString& message)
+{
+    m_error = true;
+    setErrorString(message);
+}
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_HMACDECRYPTSTREAM_H
+#define KEEPASSXC_HMACDECRYPTSTREAM_H
+
+#include <QFuture>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QSysInfo>
+#include <QThreadPool>
+#include <QVector>
+
+#include "crypto/SymmetricCipher.h"
+#include "streams/LayeredStream.h"
+
+struct z_stream_s;
+
+/**
+ * Read-only replacement for the HmacBlockStream, SymmetricCipherStream
+ * and QtIOCompressor chain of the KDBX 4 payload.
+ *
+ * Each HMAC block is read into a buffer of its own, recycled from the
+ * blocks before it, and verified and decrypted in place. Compressed
+ * payloads are inflated straight from that block into the buffer of the
+ * caller.
+ *
+ * Blocks do not depend on each other once their cipher text is known:
+ * CBC restarts from the last cipher block of the previous HMAC block and
+ * stream ciphers seek to the offset of the block. Several blocks ahead
+ * of the one being read are therefore verified and decrypted on a
+ * thread pool while the caller consumes the current one.
+ */
+class HmacDecryptStream : public LayeredStream
+{
+    Q_OBJECT
+
+public:
+    HmacDecryptStream(QIODevice* baseDevice, QByteArray hmacKey);
+    ~HmacDecryptStream() override;
+
+    bool init(SymmetricCipher::Mode mode, const QByteArray& key, const QByteArray& iv, bool compressed);
+    bool open(QIODevice::OpenMode mode) override;
+    void close() override;
+    bool atEnd() const override;
+
+    void setMaxThreadCount(int threads);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    struct Block
+    {
+        quint64 index = 0;
+        QByteArray hmac;
+        // Block data as covered by the HMAC
+        const char* hmacData = nullptr;
+        int hmacSize = 0;
+        // Cipher text decrypted in place, including the carry of the previous block
+        char* data = nullptr;
+        int size = 0;
+        QByteArray iv;
+        quint64 offset = 0;
+        bool lastBlock = false;
+        bool endOfStream = false;
+        QByteArray buffer;
+        QString error;
+        QFuture<void> future;
+    };
+
+    bool readBlockHeader(QString& error);
+    bool readBlock();
+    void fillPipeline();
+    QSharedPointer<Block> fetchBlock();
+    char* fetchData(Block& block, int size);
+    void processBlock(Block& block) const;
+    qint64 inflateData(char* data, qint64 maxSize);
+    void raiseError(const QString& message);
+
+    static const QSysInfo::Endian ByteOrder;
+
+    SymmetricCipher::Mode m_mode = SymmetricCipher::InvalidMode;
+    QByteArray m_key;
+    QByteArray m_hmacKey;
+    int m_cipherBlockSize = 0;
+    bool m_isInitialized = false;
+
+    QScopedPointer<z_stream_s> m_zstream;
+    bool m_compressed = false;
+    bool m_inflateEnd = false;
+
+    QThreadPool m_pool;
+    int m_maxPending = 1;
+    QQueue<QSharedPointer<Block>> m_pending;
+    QSharedPointer<Block> m_current;
+    QVector<QByteArray> m_freeBuffers;
+
+    // Decryption state of the next block to fetch
+    QByteArray m_iv;
+    quint64 m_streamOffset = 0;
+    // Cipher text of an incomplete cipher block at the end of the previous HMAC block
+    QByteArray m_carry;
+
+    // Decrypted data of the current block
+    const char* m_data = nullptr;
+    int m_dataSize = 0;
+    int m_dataPos = 0;
+
+    char m_blockHmac[32];
+    qint32 m_blockSize = 0;
+    bool m_headerRead = false;
+    quint64 m_blockIndex = 0;
+    bool m_fetchDone = false;
+    bool m_eof = false;
+    bool m_error = false;
+};
+
+#endif // KEEPASSXC_HMACDECRYPTSTREAM_H
@@ -0,0 +1,426 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HmacEncryptStream.h"
+
+#include <QtConcurrent>
+
+#include "core/Endian.h"
+#include "crypto/CryptoHash.h"
+#include "streams/HmacBlockStream.h"
+
+#include <zlib.h>
+
+namespace
+{
+    const int BlockSize = 1024 * 1024;
+    // Uncompressed size of a deflate chunk and the window carried over to the next one, as in pigz
+    const int ChunkSize = 128 * 1024;
+    const int DictionarySize = 32 * 1024;
+    // Same as the default of QtIOCompressor
+    const int CompressionLevel = 6;
+    const int MaxPendingJobs = 16;
+
+    // Minimal gzip member header: deflate, no flags, no time, unknown OS
+    const char GzipHeader[] = {'\x1f', '\x8b', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xff'};
+} // namespace
+
+const QSysInfo::Endian HmacEncryptStream::ByteOrder = QSysInfo::LittleEndian;
+
+HmacEncryptStream::HmacEncryptStream(QIODevice* baseDevice, QByteArray hmacKey)
+    : LayeredStream(baseDevice)
+    , m_hmacKey(std::move(hmacKey))
+{
+    setMaxThreadCount(QThread::idealThreadCount());
+}
+
+HmacEncryptStream::~HmacEncryptStream()
+{
+    close();
+}
+
+bool HmacEncryptStream::init(SymmetricCipher::Mode mode,
+                             const QByteArray& key,
+                             const QByteArray& iv,
+                             bool compressed)
+{
+    // Catch an invalid key or IV up front instead of on every block
+    SymmetricCipher cipher;
+    m_isInitialized = cipher.init(mode, SymmetricCipher::Encrypt, key, iv);
+    if (!m_isInitialized) {
+        setErrorString(cipher.errorString());
+        return false;
+    }
+    m_mode = mode;
+    m_key = key;
+    m_iv = iv;
+    m_cipherBlockSize = SymmetricCipher::blockSize(mode);
+    m_compressed = compressed;
+    return true;
+}
+
+/**
+ * Number of threads compressing, encrypting and hashing blocks behind
+ * the writer, with a single thread everything is done on the writing thread.
+ */
+void HmacEncryptStream::setMaxThreadCount(int threads)
+{
+    threads = qMax(1, threads);
+    m_pool.setMaxThreadCount(threads);
+    m_maxPending = threads > 1 ? qMin(threads * 2, MaxPendingJobs) : 1;
+}
+
+bool HmacEncryptStream::open(QIODevice::OpenMode mode)
+{
+    if (!m_isInitialized || (mode & QIODevice::ReadOnly) || !LayeredStream::open(mode)) {
+        return false;
+    }
+
+    m_payload.reserve(BlockSize);
+    if (m_compressed) {
+        m_input.reserve(ChunkSize);
+        appendPayload(GzipHeader, sizeof(GzipHeader));
+    }
+    return true;
+}
+
+bool HmacEncryptStream::reset()
+{
+    return finishPayload();
+}
+
+void HmacEncryptStream::close()
+{
+    if (isOpen()) {
+        finishPayload();
+    }
+
+    // Jobs refer to this stream, they have to be done before it goes away
+    m_pool.waitForDone();
+    m_chunks.clear();
+    m_blocks.clear();
+    m_previousBlock.reset();
+
+    LayeredStream::close();
+}
+
+qint64 HmacEncryptStream::readData(char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+qint64 HmacEncryptStream::writeData(const char* data, qint64 maxSize)
+{
+    Q_ASSERT(maxSize >= 0);
+
+    if (m_error || m_finished) {
+        return -1;
+    } else if (!m_compressed) {
+        return appendPayload(data, static_cast<int>(maxSize)) ? maxSize : -1;
+    }
+
+    qint64 bytesRemaining = maxSize;
+    qint64 offset = 0;
+
+    while (bytesRemaining > 0) {
+        qint64 bytesToCopy = qMin(bytesRemaining, static_cast<qint64>(ChunkSize - m_input.size()));
+
+        m_input.append(data + offset, static_cast<int>(bytesToCopy));
+
+        offset += bytesToCopy;
+        bytesRemaining -= bytesToCopy;
+
+        if (m_input.size() == ChunkSize && !submitChunk(false)) {
+            return -1;
+        }
+    }
+
+    return maxSize;
+}
+
+/**
+ * Writes everything that is still pending followed by the final empty block.
+ */
+bool HmacEncryptStream::finishPayload()
+{
+    if (m_finished || m_error) {
+        return !m_error;
+    }
+    m_finished = true;
+
+    if (m_compressed) {
+        if (!submitChunk(true)) {
+            return false;
+        }
+        QByteArray trailer = Endian::sizedIntToBytes<quint32>(m_crc, ByteOrder);
+        trailer.append(Endian::sizedIntToBytes<quint32>(m_inputSize, ByteOrder));
+        if (!appendPayload(trailer.constData(), trailer.size())) {
+            return false;
+        }
+    }
+
+    // The last block of block ciphers receives the padding, even if it is empty otherwise
+    if (m_cipherBlockSize > 1 || !m_payload.isEmpty()) {
+        submitBlock(true);
+    }
+    if (!drainBlocks(0)) {
+        return false;
+    }
+
+    Block finalBlock;
+    finalBlock.index = m_blockIndex++;
+    hashBlock(finalBlock);
+    return writeBlock(finalBlock.hmac, finalBlock.data);
+}
+
+bool HmacEncryptStream::submitChunk(bool last)
+{
+    QSharedPointer<Chunk> chunk(new Chunk());
+    chunk->data = std::move(m_input);
+    chunk->dictionary = m_dictionary;
+    chunk->last = last;
+
+    if (chunk->data.size() >= DictionarySize) {
+        m_dictionary = chunk->data.right(DictionarySize);
+    } else {
+        m_dictionary = (m_dictionary + chunk->data).right(DictionarySize);
+    }
+    m_input = QByteArray();
+    m_input.reserve(ChunkSize);
+
+    chunk->future = runJob([this, chunk] { compressChunk(*chunk); });
+    m_chunks.enqueue(chunk);
+
+    return drainChunks(last ? 0 : m_maxPending);
+}
+
+/**
+ * Moves finished chunks to the payload in order, waiting for the oldest
+ * ones while more than maxPending are left.
+ */
+bool HmacEncryptStream::drainChunks(int maxPending)
+{
+    while (!m_chunks.isEmpty() && (m_chunks.size() > maxPending || m_chunks.head()->future.isFinished())) {
+        auto chunk = m_chunks.dequeue();
+        chunk->future.waitForFinished();
+        if (!chunk->error.isEmpty()) {
+            raiseError(chunk->error);
+            return false;
+        }
+
+        m_crc = static_cast<quint32>(crc32_combine(m_crc, chunk->crc, chunk->data.size()));
+        m_inputSize += static_cast<quint32>(chunk->data.size());
+        if (!appendPayload(chunk->compressed.constData(), chunk->compressed.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Compresses a chunk into raw deflate data, runs on the worker threads.
+ * All but the last chunk end with a sync flush, so they are byte aligned
+ * and can be concatenated.
+ */
+void HmacEncryptStream::compressChunk(Chunk& chunk) const
+{
+    auto data = reinterpret_cast<const Bytef*>(chunk.data.constData());
+    chunk.crc = static_cast<quint32>(crc32(0, data, static_cast<uInt>(chunk.data.size())));
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, CompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        chunk.error = "Internal zlib error when compressing: " + QString::fromLatin1(stream.msg);
+        return;
+    }
+    if (!chunk.dictionary.isEmpty()) {
+        deflateSetDictionary(&stream,
+                             reinterpret_cast<const Bytef*>(chunk.dictionary.constData()),
+                             static_cast<uInt>(chunk.dictionary.size()));
+    }
+
+    // Leave room for the sync flush marker, deflateBound() only accounts for Z_FINISH
+    chunk.compressed.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(chunk.data.size()))) + 16);
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(chunk.data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(chunk.compressed.data());
+    stream.avail_out = static_cast<uInt>(chunk.compressed.size());
+
+    const int flush = chunk.last ? Z_FINISH : Z_SYNC_FLUSH;
+    int status;
+    while (true) {
+        if (stream.avail_out == 0) {
+            const int used = chunk.compressed.size();
+            chunk.compressed.resize(used + ChunkSize);
+            stream.next_out = reinterpret_cast<Bytef*>(chunk.compressed.data() + used);
+            stream.avail_out = ChunkSize;
+        }
+
+        status = deflate(&stream, flush);
+        if (status == Z_STREAM_END || (!chunk.last && status == Z_OK && stream.avail_out > 0)) {
+            status = Z_OK;
+            break;
+        } else if (status != Z_OK && !(status == Z_BUF_ERROR && stream.avail_out == 0)) {
+            break;
+        }
+    }
+
+    if (status != Z_OK) {
+        chunk.error = "Internal zlib error when compressing: "
+                      + (stream.msg ? QString::fromLatin1(stream.msg) : QString::number(status));
+    }
+    chunk.compressed.resize(static_cast<int>(stream.total_out));
+    deflateEnd(&stream);
+}
+
+bool HmacEncryptStream::appendPayload(const char* data, int size)
+{
+    while (size > 0) {
+        int bytesToCopy = qMin(size, BlockSize - m_payload.size());
+
+        m_payload.append(data, bytesToCopy);
+
+        data += bytesToCopy;
+        size -= bytesToCopy;
+
+        if (m_payload.size() == BlockSize) {
+            submitBlock(false);
+            if (!drainBlocks(m_maxPending)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void HmacEncryptStream::submitBlock(bool last)
+{
+    QSharedPointer<Block> block(new Block());
+    block->index = m_blockIndex++;
+    block->data = std::move(m_payload);
+    block->iv = m_iv;
+    block->last = last;
+    m_payload = QByteArray();
+    m_payload.reserve(BlockSize);
+
+    QSharedPointer<Block> previous;
+    if (m_cipherBlockSize > 1) {
+        // CBC continues from the last cipher block of the previous block
+        previous = m_previousBlock;
+        m_previousBlock = block;
+    } else {
+        block->offset = m_streamOffset;
+        m_streamOffset += static_cast<quint64>(block->data.size());
+    }
+
+    block->encrypted = runJob([this, block, previous] { encryptBlock(*block, previous.data()); });
+    block->future = runJob([this, block] {
+        block->encrypted.waitForFinished();
+        hashBlock(*block);
+    });
+    m_blocks.enqueue(block);
+}
+
+/**
+ * Writes finished blocks to the base device in order, waiting for the
+ * oldest ones while more than maxPending are left.
+ */
+bool HmacEncryptStream::drainBlocks(int maxPending)
+{
+    while (!m_blocks.isEmpty() && (m_blocks.size() > maxPending || m_blocks.head()->future.isFinished())) {
+        auto block = m_blocks.dequeue();
+        block->future.waitForFinished();
+        if (!block->error.isEmpty()) {
+            raiseError(block->error);
+            return false;
+        } else if (!writeBlock(block->hmac, block->data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Encrypts a block in place, runs on the worker threads.
+ */
+void HmacEncryptStream::encryptBlock(Block& block, const Block* previous) const
+{
+    if (previous) {
+        // Blocks are submitted in order, so the previous block has already been picked up by the pool
+        previous->encrypted.waitForFinished();
+        if (!previous->error.isEmpty()) {
+            block.error = previous->error;
+            return;
+        }
+        block.iv = previous->data.right(m_cipherBlockSize);
+    }
+
+    SymmetricCipher cipher;
+    bool ok = cipher.init(m_mode, SymmetricCipher::Encrypt, m_key, block.iv)
+              && (block.offset == 0 || cipher.seek(block.offset));
+
+    if (ok && block.last && m_cipherBlockSize > 1) {
+        ok = cipher.finish(block.data);
+    } else if (ok && !block.data.isEmpty()) {
+        ok = cipher.process(block.data);
+    }
+
+    if (!ok) {
+        block.error = cipher.errorString();
+    }
+}
+
+void HmacEncryptStream::hashBlock(Block& block) const
+{
+    if (!block.error.isEmpty()) {
+        return;
+    }
+
+    CryptoHash hasher(CryptoHash::Sha256, true);
+    hasher.setKey(HmacBlockStream::getHmacKey(block.index, m_hmacKey));
+    hasher.addData(Endian::sizedIntToBytes<quint64>(block.index, ByteOrder));
+    hasher.addData(Endian::sizedIntToBytes<qint32>(block.data.size(), ByteOrder));
+    hasher.addData(block.data);
+    block.hmac = hasher.result();
+}
+
+bool HmacEncryptStream::writeBlock(const QByteArray& hmac, const QByteArray& data)
+{
+    if (m_baseDevice->write(hmac) != hmac.size()
+        || !Endian::writeSizedInt<qint32>(data.size(), m_baseDevice, ByteOrder)
+        || (!data.isEmpty() && m_baseDevice->write(data) != data.size())) {
+        raiseError(m_baseDevice->errorString());
+        return false;
+    }
+    return true;
+}
+
+QFuture<void> HmacEncryptStream::runJob(const std::function<void()>& job)
+{
+    if (m_maxPending > 1) {
+        return QtConcurrent::run(&m_pool, job);
+    }
+    job();
+    return {};
+}
+
+void HmacEncryptStream::raiseError(const QString& message)
+{
+    m_error = true;
+    setErrorString(message);
+}
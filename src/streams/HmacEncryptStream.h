@@ -0,0 +1,134 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_HMACENCRYPTSTREAM_H
+#define KEEPASSXC_HMACENCRYPTSTREAM_H
+
+#include <QFuture>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QSysInfo>
+#include <QThreadPool>
+
+#include <functional>
+
+#include "crypto/SymmetricCipher.h"
+#include "streams/LayeredStream.h"
+
+/**
+ * Write-only replacement for the QtIOCompressor, SymmetricCipherStream
+ * and HmacBlockStream chain of the KDBX 4 payload.
+ *
+ * Compression, encryption and the HMAC of each block run on a thread
+ * pool while the caller keeps writing:
+ *  - The input is compressed in independent raw deflate chunks, each
+ *    primed with the end of the previous one, and wrapped in a single
+ *    gzip member like pigz does.
+ *  - Stream ciphers encrypt every 1 MiB block at its own offset. CBC
+ *    has to chain the blocks, so their encryption stays in order but
+ *    overlaps with the compression and HMAC of other blocks.
+ *  - Blocks are written to the base device in order.
+ */
+class HmacEncryptStream : public LayeredStream
+{
+    Q_OBJECT
+
+public:
+    HmacEncryptStream(QIODevice* baseDevice, QByteArray hmacKey);
+    ~HmacEncryptStream() override;
+
+    bool init(SymmetricCipher::Mode mode, const QByteArray& key, const QByteArray& iv, bool compressed);
+    bool open(QIODevice::OpenMode mode) override;
+    bool reset() override;
+    void close() override;
+
+    void setMaxThreadCount(int threads);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    struct Chunk
+    {
+        QByteArray data;
+        QByteArray dictionary;
+        bool last = false;
+        QByteArray compressed;
+        quint32 crc = 0;
+        QString error;
+        QFuture<void> future;
+    };
+
+    struct Block
+    {
+        quint64 index = 0;
+        QByteArray data;
+        QByteArray iv;
+        quint64 offset = 0;
+        bool last = false;
+        QByteArray hmac;
+        QString error;
+        QFuture<void> encrypted;
+        QFuture<void> future;
+    };
+
+    bool finishPayload();
+    bool submitChunk(bool last);
+    bool drainChunks(int maxPending);
+    void compressChunk(Chunk& chunk) const;
+    bool appendPayload(const char* data, int size);
+    void submitBlock(bool last);
+    bool drainBlocks(int maxPending);
+    void encryptBlock(Block& block, const Block* previous) const;
+    void hashBlock(Block& block) const;
+    bool writeBlock(const QByteArray& hmac, const QByteArray& data);
+    QFuture<void> runJob(const std::function<void()>& job);
+    void raiseError(const QString& message);
+
+    static const QSysInfo::Endian ByteOrder;
+
+    SymmetricCipher::Mode m_mode = SymmetricCipher::InvalidMode;
+    QByteArray m_key;
+    QByteArray m_iv;
+    QByteArray m_hmacKey;
+    int m_cipherBlockSize = 0;
+    bool m_isInitialized = false;
+    bool m_compressed = false;
+
+    QThreadPool m_pool;
+    int m_maxPending = 1;
+
+    // Uncompressed input and the compression state
+    QByteArray m_input;
+    QByteArray m_dictionary;
+    QQueue<QSharedPointer<Chunk>> m_chunks;
+    quint32 m_crc = 0;
+    quint32 m_inputSize = 0;
+
+    // Compressed payload and the blocks being encrypted
+    QByteArray m_payload;
+    QQueue<QSharedPointer<Block>> m_blocks;
+    QSharedPointer<Block> m_previousBlock;
+    quint64 m_blockIndex = 0;
+    quint64 m_streamOffset = 0;
+
+    bool m_finished = false;
+    bool m_error = false;
+};
+
+#endif // KEEPASSXC_HMACENCRYPTSTREAM_H
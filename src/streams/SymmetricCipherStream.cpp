@@ -123,23 +123,18 @@ qint64 SymmetricCipherStream::readData(char* data, qint64 maxSize)
 
 bool SymmetricCipherStream::readBlock()
 {
-    QByteArray newData;
+    // Read straight into the block buffer, it keeps its capacity between blocks
+    int offset = m_bufferFilling ? m_buffer.size() : 0;
+    m_buffer.resize(blockSize());
 
-    if (m_bufferFilling) {
-        newData.resize(blockSize() - m_buffer.size());
-    } else {
-        m_buffer.clear();
-        newData.resize(blockSize());
-    }
-
-    int readResult = m_baseDevice->read(newData.data(), newData.size());
+    int readResult = m_baseDevice->read(m_buffer.data() + offset, m_buffer.size() - offset);
 
     if (readResult == -1) {
         m_error = true;
         setErrorString(m_baseDevice->errorString());
         return false;
     } else {
-        m_buffer.append(newData.left(readResult));
+        m_buffer.resize(offset + readResult);
     }
 
     if (!m_streamCipher && m_buffer.size() != blockSize()) {
@@ -230,7 +225,7 @@ bool SymmetricCipherStream::writeBlock(bool lastBlock)
 int SymmetricCipherStream::blockSize() const
 {
     if (m_streamCipher) {
-        return 1024;
+        return 64 * 1024;
     }
     return m_cipher->blockSize(m_cipher->mode());
 }
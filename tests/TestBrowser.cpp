@@ -373,6 +373,39 @@ void TestBrowser::testSearchEntriesWithAdditionalURLs()
     QCOMPARE(additionalResult[0]->url(), QString("https://github.com/"));
 }
 
+void TestBrowser::testSearchEntriesAfterChanges()
+{
+    auto db = QSharedPointer<Database>::create();
+    auto* root = db->rootGroup();
+
+    QStringList urls = {"https://github.com/", "https://www.example.com"};
+    auto entries = createEntries(urls, root);
+
+    auto result = m_browserService->searchEntries(db, "https://www.example.com", "https://www.example.com");
+    QCOMPARE(result.length(), 1);
+    QCOMPARE(result[0], entries[1]);
+
+    // Changed URLs are picked up by the following searches
+    entries[0]->setUrl("https://login.example.com");
+    result = m_browserService->searchEntries(db, "https://login.example.com", "https://login.example.com");
+    QCOMPARE(result.length(), 1);
+    QCOMPARE(result[0], entries[0]);
+
+    entries[1]->attributes()->set(BrowserService::ADDITIONAL_URL, "https://github.com");
+    result = m_browserService->searchEntries(db, "https://github.com", "https://github.com");
+    QCOMPARE(result.length(), 1);
+    QCOMPARE(result[0], entries[1]);
+
+    // Hidden and deleted entries are not returned
+    entries[0]->customData()->set(BrowserService::OPTION_HIDE_ENTRY, TRUE_STR);
+    result = m_browserService->searchEntries(db, "https://login.example.com", "https://login.example.com");
+    QVERIFY(result.isEmpty());
+
+    delete entries[1];
+    result = m_browserService->searchEntries(db, "https://github.com", "https://github.com");
+    QVERIFY(result.isEmpty());
+}
+
 void TestBrowser::testInvalidEntries()
 {
     auto db = QSharedPointer<Database>::create();
@@ -24,6 +24,8 @@
 #include "core/Metadata.h"
 #include "core/Tools.h"
 #include "crypto/Crypto.h"
+#include "crypto/kdf/Argon2Kdf.h"
+#include "format/KeePass2.h"
 #include "keys/FileKey.h"
 #include "keys/drivers/YubiKey.h"
 
@@ -41,6 +43,7 @@
 #include "cli/Export.h"
 #include "cli/Generate.h"
 #include "cli/Help.h"
+#include "cli/HibpIndex.h"
 #include "cli/Import.h"
 #include "cli/Info.h"
 #include "cli/List.h"
@@ -231,6 +234,7 @@ void TestCli::testBatchCommands()
     QVERIFY(Commands::getCommand("export"));
     QVERIFY(Commands::getCommand("generate"));
     QVERIFY(Commands::getCommand("help"));
+    QVERIFY(Commands::getCommand("hibp-index"));
     QVERIFY(Commands::getCommand("import"));
     QVERIFY(Commands::getCommand("ls"));
     QVERIFY(Commands::getCommand("merge"));
@@ -242,7 +246,7 @@ void TestCli::testBatchCommands()
     QVERIFY(Commands::getCommand("show"));
     QVERIFY(Commands::getCommand("search"));
     QVERIFY(!Commands::getCommand("doesnotexist"));
-    QCOMPARE(Commands::getCommands().size(), 25);
+    QCOMPARE(Commands::getCommands().size(), 26);
 }
 
 void TestCli::testInteractiveCommands()
@@ -263,6 +267,7 @@ void TestCli::testInteractiveCommands()
     QVERIFY(Commands::getCommand("exit"));
     QVERIFY(Commands::getCommand("generate"));
     QVERIFY(Commands::getCommand("help"));
+    QVERIFY(Commands::getCommand("hibp-index"));
     QVERIFY(Commands::getCommand("ls"));
     QVERIFY(Commands::getCommand("merge"));
     QVERIFY(Commands::getCommand("mkdir"));
@@ -274,7 +279,7 @@ void TestCli::testInteractiveCommands()
     QVERIFY(Commands::getCommand("show"));
     QVERIFY(Commands::getCommand("search"));
     QVERIFY(!Commands::getCommand("doesnotexist"));
-    QCOMPARE(Commands::getCommands().size(), 25);
+    QCOMPARE(Commands::getCommands().size(), 26);
 }
 
 void TestCli::testAdd()
@@ -840,6 +845,33 @@ void TestCli::testCreate()
 
     db = readDatabase(dbFilename, "a");
     QVERIFY(db);
+
+    // Maximum memory without calibration
+    dbFilename = testDir->path() + "/testCreate_calibrate.kdbx";
+    execCmd(createCmd, {"db-create", dbFilename, "-p", "--max-memory", "16"});
+
+    QCOMPARE(m_stdout->readAll(), QByteArray());
+    QCOMPARE(m_stderr->readAll(), QByteArray("The maximum memory can only be set together with --calibrate.\n"));
+
+    // Maximum memory that wraps around when converted to bytes
+    execCmd(createCmd, {"db-create", dbFilename, "-p", "--calibrate", "--max-memory", "18014398509481985"});
+
+    QCOMPARE(m_stdout->readAll(), QByteArray());
+    QCOMPARE(m_stderr->readAll(), QByteArray("Invalid maximum memory 18014398509481985.\n"));
+
+    // Calibrated Argon2 settings
+    setInput({"a", "a"});
+    execCmd(createCmd, {"db-create", dbFilename, "-p", "--calibrate", "-t", "200", "--max-memory", "16"});
+
+    QCOMPARE(m_stderr->readLine(), QByteArray("Enter password to encrypt database (optional): \n"));
+    QCOMPARE(m_stderr->readLine(), QByteArray("Repeat password: \n"));
+    QCOMPARE(m_stdout->readLine(), QByteArray("Calibrating Argon2 for 200ms delay.\n"));
+    QVERIFY(m_stdout->readLine().contains(QByteArray("threads for key derivation function.\n")));
+
+    db = readDatabase(dbFilename, "a");
+    QVERIFY(db);
+    QCOMPARE(db->kdf()->uuid(), KeePass2::KDF_ARGON2D);
+    QVERIFY(db->kdf().staticCast<Argon2Kdf>()->memory() <= 16 * 1024);
 }
 
 void TestCli::testInfo()
@@ -1252,6 +1284,45 @@ void TestCli::testGenerate()
     QCOMPARE(m_stderr->readLine(), QByteArray("Invalid password length bleuh\n"));
 }
 
+void TestCli::testGenerateCount()
+{
+    Generate generateCmd;
+    execCmd(generateCmd, {"generate", "-L", "12", "-l", "--count", "5000"});
+    QStringList passwords = QString::fromUtf8(m_stdout->readAll()).split("\n", QString::SkipEmptyParts);
+    QCOMPARE(passwords.size(), 5000);
+    QRegularExpression passwordRegex("^[a-z]{12}$");
+    for (const auto& password : passwords) {
+        QVERIFY2(passwordRegex.match(password).hasMatch(), qPrintable("Password " + password + " is invalid"));
+    }
+    QCOMPARE(m_stderr->readAll(), QByteArray());
+
+    execCmd(generateCmd, {"generate", "-L", "12", "-n", "--count", "10000", "--threads", "3"});
+    passwords = QString::fromUtf8(m_stdout->readAll()).split("\n", QString::SkipEmptyParts);
+    QCOMPARE(passwords.size(), 10000);
+    passwordRegex.setPattern("^[0-9]{12}$");
+    for (const auto& password : passwords) {
+        QVERIFY2(passwordRegex.match(password).hasMatch(), qPrintable("Password " + password + " is invalid"));
+    }
+
+    execCmd(generateCmd, {"generate", "--count", "0"});
+    QCOMPARE(m_stderr->readLine(), QByteArray("Invalid count 0\n"));
+    QCOMPARE(m_stdout->readAll(), QByteArray());
+
+    execCmd(generateCmd, {"generate", "--count", "2", "--threads", "none"});
+    QCOMPARE(m_stderr->readLine(), QByteArray("Invalid thread count none\n"));
+
+    Diceware dicewareCmd;
+    execCmd(dicewareCmd, {"diceware", "-W", "3", "--count", "4100", "--threads", "2"});
+    const QStringList passphrases = QString::fromUtf8(m_stdout->readAll()).split("\n", QString::SkipEmptyParts);
+    QCOMPARE(passphrases.size(), 4100);
+    for (const auto& passphrase : passphrases) {
+        QCOMPARE(passphrase.split(" ").size(), 3);
+    }
+
+    execCmd(dicewareCmd, {"diceware", "--count", "-1"});
+    QCOMPARE(m_stderr->readLine(), QByteArray("Invalid count -1\n"));
+}
+
 void TestCli::testImport()
 {
     Import importCmd;
@@ -2206,3 +2277,57 @@ void TestCli::testHelp()
     execCmd(helpCmd, {"help", "ls"});
     QVERIFY(m_stdout->readAll().contains(listCmd.description.toLatin1()));
 }
+
+void TestCli::testHibpIndex()
+{
+    HibpIndex hibpIndexCmd;
+    QVERIFY(!hibpIndexCmd.name.isEmpty());
+    QVERIFY(hibpIndexCmd.getDescriptionLine().contains(hibpIndexCmd.name));
+
+    TemporaryFile indexFile;
+    indexFile.open(QIODevice::WriteOnly);
+    indexFile.close();
+
+    // The sample HIBP file is ordered by prevalence, which cannot be indexed
+    const QString hibpPath = QString(KEEPASSX_TEST_DATA_DIR).append("/hibp.txt");
+    QCOMPARE(execCmd(hibpIndexCmd, {"hibp-index", hibpPath, indexFile.fileName()}), EXIT_FAILURE);
+    QVERIFY(m_stderr->readAll().contains("not sorted by hash"));
+
+    QFile hibpFile(hibpPath);
+    QVERIFY(hibpFile.open(QIODevice::ReadOnly));
+    auto lines = hibpFile.readAll().split('\n');
+    lines.removeAll({});
+    std::sort(lines.begin(), lines.end());
+
+    TemporaryFile sortedHibpFile;
+    QVERIFY(sortedHibpFile.open(QIODevice::WriteOnly));
+    sortedHibpFile.write(lines.join('\n'));
+    sortedHibpFile.close();
+
+    QCOMPARE(execCmd(hibpIndexCmd, {"hibp-index", "-q", sortedHibpFile.fileName(), indexFile.fileName()}),
+             EXIT_SUCCESS);
+    QCOMPARE(m_stderr->readAll(), QByteArray());
+
+    // Counts that do not fit the index are rejected instead of wrapping around
+    TemporaryFile overflowHibpFile;
+    QVERIFY(overflowHibpFile.open(QIODevice::WriteOnly));
+    overflowHibpFile.write(lines.first().split(':').first() + ":4294967296\n");
+    overflowHibpFile.close();
+
+    TemporaryFile overflowIndexFile;
+    overflowIndexFile.open(QIODevice::WriteOnly);
+    overflowIndexFile.close();
+    QCOMPARE(execCmd(hibpIndexCmd, {"hibp-index", "-q", overflowHibpFile.fileName(), overflowIndexFile.fileName()}),
+             EXIT_FAILURE);
+    QVERIFY(m_stderr->readAll().contains("line 1: parse error"));
+
+    // The index can be used in place of the HIBP file
+    Analyze analyzeCmd;
+    setInput("a");
+    execCmd(analyzeCmd, {"analyze", "--hibp", indexFile.fileName(), m_dbFile->fileName()});
+    auto output = m_stdout->readAll();
+    QVERIFY(output.contains("Sample Entry"));
+    QVERIFY(output.contains("123"));
+    m_stderr->readLine(); // Skip password prompt
+    QCOMPARE(m_stderr->readAll(), QByteArray());
+}
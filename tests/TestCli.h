@@ -61,11 +61,13 @@ private slots:
     void testExport();
     void testGenerate_data();
     void testGenerate();
+    void testGenerateCount();
     void testImport();
     void testInfo();
     void testKeyFileOption();
     void testNoPasswordOption();
     void testHelp();
+    void testHibpIndex();
     void testInteractiveCommands();
     void testList();
     void testMerge();
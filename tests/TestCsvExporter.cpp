@@ -21,6 +21,7 @@
 #include <QBuffer>
 #include <QTest>
 
+#include "FailDevice.h"
 #include "core/Group.h"
 #include "crypto/Crypto.h"
 #include "format/CsvExporter.h"
@@ -110,3 +111,44 @@ void TestCsvExporter::testNestedGroups()
             .append(ExpectedHeaderLine)
             .append("\"Passwords/Test Group Name/Test Sub Group Name\",\"Test Entry Title\",\"\",\"\",\"\",\"\"")));
 }
+
+void TestCsvExporter::testLargeDatabase()
+{
+    const int entryCount = 2000;
+    for (int i = 0; i < entryCount; ++i) {
+        auto* entry = new Entry();
+        entry->setGroup(m_db->rootGroup());
+        entry->setTitle(QString("Entry \u00e9 %1").arg(i));
+        entry->setNotes("Line 1\n\"Line 2\"");
+    }
+
+    // Rows are streamed in several writes and have to end up complete and in order
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(m_csvExporter->exportDatabase(&buffer, m_db));
+    auto exported = QString::fromUtf8(buffer.buffer());
+    QCOMPARE(exported, m_csvExporter->exportDatabase(m_db));
+    QVERIFY(exported.startsWith(ExpectedHeaderLine));
+
+    int pos = ExpectedHeaderLine.size();
+    for (int i = 0; i < entryCount; ++i) {
+        const auto row = QString("\"Passwords\",\"Entry \u00e9 %1\",\"\",\"\",\"\",\"Line 1\n\"\"Line 2\"\"\"").arg(i);
+        QCOMPARE(exported.mid(pos, row.size()), row);
+        pos = exported.indexOf("\n", exported.indexOf("\"\"\"", pos) + 3) + 1;
+    }
+    QCOMPARE(pos, exported.size());
+}
+
+void TestCsvExporter::testWriteFailure()
+{
+    for (int i = 0; i < 2000; ++i) {
+        auto* entry = new Entry();
+        entry->setGroup(m_db->rootGroup());
+        entry->setTitle(QString("Entry %1").arg(i));
+    }
+
+    FailDevice failDevice(1000);
+    QVERIFY(failDevice.open(QIODevice::WriteOnly));
+    QVERIFY(!m_csvExporter->exportDatabase(&failDevice, m_db));
+    QCOMPARE(m_csvExporter->errorString(), QString("FAILDEVICE"));
+}
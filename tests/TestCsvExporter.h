@@ -39,6 +39,8 @@ private slots:
     void testExport();
     void testEmptyDatabase();
     void testNestedGroups();
+    void testLargeDatabase();
+    void testWriteFailure();
 
 private:
     QSharedPointer<Database> m_db;
@@ -344,3 +344,23 @@ void TestCsvParser::testUnicode()
     QVERIFY(t.at(0).at(2) == "3śAż");
     QVERIFY(t.at(0).at(3) == "żac");
 }
+
+void TestCsvParser::testChunkBoundaries()
+{
+    // Line breaks, quoted fields and multi-byte characters have to survive being split between chunks
+    const int rowCount = 20000;
+    QTextStream out(file.data());
+    out.setCodec("UTF-8");
+    for (int i = 0; i < rowCount; ++i) {
+        out << QString("\u015b%1,\"a\r\n\"\"b\"\r\n").arg(i);
+    }
+
+    QVERIFY(parser->parse(file.data()));
+    t = parser->getCsvTable();
+    QCOMPARE(t.size(), rowCount);
+    for (int i = 0; i < rowCount; ++i) {
+        QCOMPARE(t.at(i).size(), 2);
+        QCOMPARE(t.at(i).at(0), QString("\u015b%1").arg(i));
+        QCOMPARE(t.at(i).at(1), QString("a\n\"b"));
+    }
+}
@@ -57,6 +57,7 @@ private slots:
     void testQuoted();
     void testMultiline();
     void testColumns();
+    void testChunkBoundaries();
 
 private:
     QScopedPointer<QTemporaryFile> file;
@@ -16,14 +16,17 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QDir>
 #include <QTest>
 
 #include "TestEntry.h"
+#include "core/AttachmentStore.h"
 #include "core/Clock.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
 #include "core/TimeInfo.h"
 #include "crypto/Crypto.h"
+#include "crypto/CryptoHash.h"
 
 QTEST_GUILESS_MAIN(TestEntry)
 
@@ -82,6 +85,46 @@ void TestEntry::testCopyDataFrom()
     QCOMPARE(entry2->autoTypeAssociations()->get(1).window, QString("3"));
 }
 
+void TestEntry::testSharedAttachments()
+{
+    const int storedBlobs = AttachmentStore::instance()->size();
+
+    QScopedPointer<Entry> entry1(new Entry());
+    QScopedPointer<Entry> entry2(new Entry());
+
+    // Identical data from independent sources is stored once
+    QByteArray data1(1024, 'a');
+    QByteArray data2(1024, 'a');
+    QVERIFY(data1.constData() != data2.constData());
+    entry1->attachments()->set("key.pem", data1);
+    entry2->attachments()->set("other.pem", data2);
+    QCOMPARE(AttachmentStore::instance()->size(), storedBlobs + 1);
+    QCOMPARE(entry1->attachments()->value("key.pem").constData(),
+             entry2->attachments()->value("other.pem").constData());
+    QCOMPARE(entry1->attachments()->hash("key.pem"), CryptoHash::hash(data1, CryptoHash::Sha256));
+    QCOMPARE(entry1->attachments()->hash("key.pem"), entry2->attachments()->hash("other.pem"));
+    QVERIFY(entry1->attachments()->hash("missing").isEmpty());
+
+    // History items share the blob with the entry
+    entry1->attachments()->set("cert.der", QByteArray(512, 'b'));
+    QCOMPARE(AttachmentStore::instance()->size(), storedBlobs + 2);
+    entry1->beginUpdate();
+    entry1->setTitle("changed");
+    entry1->endUpdate();
+    QCOMPARE(entry1->historyItems().size(), 1);
+    QCOMPARE(AttachmentStore::instance()->size(), storedBlobs + 2);
+    QVERIFY(*entry1->historyItems().first()->attachments() == *entry1->attachments());
+
+    entry1->attachments()->rename("cert.der", "cert2.der");
+    QCOMPARE(AttachmentStore::instance()->size(), storedBlobs + 2);
+
+    // Blobs are released with their last user
+    entry2->attachments()->clear();
+    QCOMPARE(AttachmentStore::instance()->size(), storedBlobs + 2);
+    entry1.reset();
+    QCOMPARE(AttachmentStore::instance()->size(), storedBlobs);
+}
+
 void TestEntry::testClone()
 {
     QScopedPointer<Entry> entryOrg(new Entry());
@@ -442,6 +485,127 @@ void TestEntry::testResolveReferencePlaceholders()
              entry3->attributes()->value("AttributeNotes"));
 }
 
+void TestEntry::testResolveReferenceAfterChanges()
+{
+    Database db;
+    auto* root = db.rootGroup();
+
+    auto* entry1 = new Entry();
+    entry1->setGroup(root);
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setTitle("Shared");
+    entry1->setPassword("Password1");
+
+    auto* tstEntry = new Entry();
+    tstEntry->setGroup(root);
+    tstEntry->setUuid(QUuid::createUuid());
+    tstEntry->setPassword("{REF:P@T:Shared}");
+
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(tstEntry->password()), QString("Password1"));
+
+    // Changed field values are picked up
+    entry1->setPassword("Password2");
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(tstEntry->password()), QString("Password2"));
+
+    // The first entry in tree order wins
+    auto* group = new Group();
+    group->setParent(root);
+    auto* entry2 = new Entry();
+    entry2->setUuid(QUuid::createUuid());
+    entry2->setTitle("Shared");
+    entry2->setPassword("Password3");
+    entry2->setGroup(group);
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(tstEntry->password()), QString("Password2"));
+
+    entry1->setTitle("Renamed");
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(tstEntry->password()), QString("Password3"));
+
+    delete entry2;
+    QCOMPARE(tstEntry->resolveMultiplePlaceholders(tstEntry->password()), QString());
+}
+
+void TestEntry::testResolvedFieldCache()
+{
+    Database db;
+    auto* root = db.rootGroup();
+
+    auto* entry1 = new Entry();
+    entry1->setGroup(root);
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setTitle("Title1");
+    entry1->setUsername("Username1");
+
+    auto* tstEntry = new Entry();
+    tstEntry->setGroup(root);
+    tstEntry->setUuid(QUuid::createUuid());
+    tstEntry->setTitle("{REF:T@U:Username1}");
+    tstEntry->setUsername("{TITLE}");
+    tstEntry->setPassword("{REF:U@T:Title1}");
+    tstEntry->setUrl("{DB_DIR}");
+
+    QCOMPARE(tstEntry->resolvedTitle(), QString("Title1"));
+    QCOMPARE(tstEntry->resolvedUsername(), QString("Title1"));
+    QCOMPARE(tstEntry->resolvedPassword(), QString("Username1"));
+
+    // Changes to the entry itself and to referenced entries are picked up
+    tstEntry->setUsername("{PASSWORD}");
+    QCOMPARE(tstEntry->resolvedUsername(), QString("Username1"));
+    entry1->setTitle("Title2");
+    QCOMPARE(tstEntry->resolvedTitle(), QString("Title2"));
+    QCOMPARE(tstEntry->resolvedPassword(), QString());
+
+    // Values depending on state outside of the entries are not cached
+    db.setFilePath(QDir::temp().absoluteFilePath("db1.kdbx"));
+    QCOMPARE(tstEntry->resolvedUrl(), QDir::temp().absolutePath());
+    db.setFilePath(QDir::home().absoluteFilePath("db1.kdbx"));
+    QCOMPARE(tstEntry->resolvedUrl(), QDir::home().absolutePath());
+
+    // Entries moved to another database resolve against that database
+    Database db2;
+    auto* entry2 = new Entry();
+    entry2->setGroup(db2.rootGroup());
+    entry2->setUuid(QUuid::createUuid());
+    entry2->setTitle("Title3");
+    entry2->setUsername("Username1");
+    tstEntry->setGroup(db2.rootGroup());
+    QCOMPARE(tstEntry->resolvedTitle(), QString("Title3"));
+}
+
+void TestEntry::benchmarkResolveReferences()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    Database db;
+    auto* root = db.rootGroup();
+
+    // 10k entries, half of them referencing the other half by title
+    QList<Entry*> referencing;
+    for (int i = 0; i < 5000; ++i) {
+        auto* entry = new Entry();
+        entry->setUuid(QUuid::createUuid());
+        entry->setTitle(QString("Title%1").arg(i));
+        entry->setUsername(QString("Username%1").arg(i));
+        entry->setGroup(root);
+
+        auto* reference = new Entry();
+        reference->setUuid(QUuid::createUuid());
+        reference->setUsername(QString("{REF:U@T:Title%1}").arg(i));
+        reference->setGroup(root);
+        referencing.append(reference);
+    }
+
+    QBENCHMARK
+    {
+        for (const auto* entry : referencing) {
+            entry->resolveMultiplePlaceholders(entry->username());
+        }
+    };
+}
+
 void TestEntry::testResolveNonIdPlaceholdersToUuid()
 {
     Database db;
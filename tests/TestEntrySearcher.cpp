@@ -16,12 +16,19 @@
  */
 
 #include "TestEntrySearcher.h"
+#include "core/EntrySearchIndex.h"
 #include "core/Group.h"
+#include "crypto/Crypto.h"
 
 #include <QTest>
 
 QTEST_GUILESS_MAIN(TestEntrySearcher)
 
+void TestEntrySearcher::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
 void TestEntrySearcher::init()
 {
     m_rootGroup = new Group();
@@ -242,6 +249,17 @@ void TestEntrySearcher::testSearchTermParser()
     QCOMPARE(terms[1].field, EntrySearcher::Field::AttributeValue);
     QCOMPARE(terms[1].word, QString("def"));
     QCOMPARE(terms[1].regex.pattern(), QString("ddd"));
+
+    // Test terms are evaluated cheapest first
+    m_entrySearcher.parseSearchTerms("attribute:abc noquote notes:efg title:ddd");
+    m_entrySearcher.compileSearchTerms();
+    terms = m_entrySearcher.m_plan;
+
+    QCOMPARE(terms.length(), 4);
+    QCOMPARE(terms[0].field, EntrySearcher::Field::Title);
+    QCOMPARE(terms[1].field, EntrySearcher::Field::Notes);
+    QCOMPARE(terms[2].field, EntrySearcher::Field::Undefined);
+    QCOMPARE(terms[3].field, EntrySearcher::Field::AttributeKV);
 }
 
 void TestEntrySearcher::testCustomAttributesAreSearched()
@@ -372,3 +390,136 @@ void TestEntrySearcher::testSkipProtected()
         m_entrySearcher.search("_testAttribute:testE1 _testProtected:apple _testAttribute:testE2", m_rootGroup);
     QCOMPARE(m_searchResult, {});
 }
+
+void TestEntrySearcher::testSearchIndex()
+{
+    Database db;
+    auto* root = db.rootGroup();
+
+    auto* group = new Group();
+    group->setName("Group");
+    group->setParent(root);
+
+    auto* e1 = new Entry();
+    e1->setTitle("Example Website");
+    e1->setUsername("alice");
+    e1->setGroup(root);
+
+    auto* e2 = new Entry();
+    e2->setTitle("Mail");
+    e2->setUrl("https://mail.example.com");
+    e2->setNotes("Shared key");
+    e2->setGroup(group);
+
+    auto* e3 = new Entry();
+    e3->setTitle("{REF:T@U:alice}");
+    e3->setGroup(group);
+
+    // One-shot searchers do not build the index
+    m_searchResult = m_entrySearcher.search("example", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e2 << e3);
+    QVERIFY(!db.searchIndex()->isBuilt());
+
+    // The index is built in the background, all entries are searched meanwhile
+    auto* removed = new Entry();
+    removed->setTitle("Removed Example");
+    removed->setGroup(group);
+    m_entrySearcher.setIndexed(true);
+    m_searchResult = m_entrySearcher.search("example", root);
+    QVERIFY(!db.searchIndex()->isBuilt());
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e2 << e3 << removed);
+
+    // Entries changed, added and removed during the build are picked up
+    e2->setNotes("Shared secret");
+    auto* added = new Entry();
+    added->setTitle("Sample");
+    added->setGroup(root);
+    delete removed;
+    QTRY_VERIFY(db.searchIndex()->isBuilt());
+    m_searchResult = m_entrySearcher.search("secret", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e2);
+    m_searchResult = m_entrySearcher.search("sample", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << added);
+    delete added;
+    e2->setNotes("Shared key");
+
+    m_searchResult = m_entrySearcher.search("example", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e2 << e3);
+
+    m_searchResult = m_entrySearcher.search("title:EXAMPLE", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e3);
+
+    m_searchResult = m_entrySearcher.search("url:ex*com", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e2);
+
+    m_searchResult = m_entrySearcher.search("notes:key", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e2);
+
+    // Terms the index cannot narrow down still work
+    m_searchResult = m_entrySearcher.search("-title:mail ex", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e3);
+
+    m_searchResult = m_entrySearcher.search("title:mail|website", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e2 << e3);
+
+    // Modified, added, moved and removed entries are picked up
+    e1->setTitle("Other Website");
+    m_searchResult = m_entrySearcher.search("title:example", root);
+    QVERIFY(m_searchResult.isEmpty());
+
+    auto* e4 = new Entry();
+    e4->setTitle("Another Example");
+    e4->setGroup(root);
+    m_searchResult = m_entrySearcher.search("title:example", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e4);
+
+    e4->setGroup(group);
+    m_searchResult = m_entrySearcher.search("title:example", group);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e4);
+
+    e1->setTitle("Example Website");
+    delete e4;
+    m_searchResult = m_entrySearcher.search("title:example", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e3);
+
+    // Blocking modified signals without changes, as saving does, keeps the index
+    db.setEmitModified(false);
+    db.setEmitModified(true);
+    QVERIFY(db.searchIndex()->isBuilt());
+
+    // Changes made while modified signals are blocked are picked up as well
+    db.setEmitModified(false);
+    e2->setTitle("Example Mail");
+    e1->setTags("Shared");
+    db.setEmitModified(true);
+    m_searchResult = m_entrySearcher.search("title:example", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1 << e2 << e3);
+    m_searchResult = m_entrySearcher.search("tag:shared", root);
+    QCOMPARE(m_searchResult, QList<Entry*>() << e1);
+}
+
+void TestEntrySearcher::testParallelSearch()
+{
+    QList<Group*> groups{m_rootGroup};
+    for (int i = 0; i < 10; ++i) {
+        auto* group = new Group();
+        group->setName(QString("Group %1").arg(i));
+        group->setParent(groups.at(i / 2));
+        groups.append(group);
+    }
+
+    for (int i = 0; i < 10000; ++i) {
+        auto* entry = new Entry();
+        entry->setTitle(QString("Entry %1").arg(i));
+        entry->setUsername(i % 3 == 0 ? "user" : "other");
+        entry->setGroup(groups.at(i % groups.size()));
+    }
+
+    const QString searchString("user entry*9");
+    const auto expected = m_entrySearcher.search(searchString, m_rootGroup);
+    QVERIFY(!expected.isEmpty());
+
+    EntrySearcher parallelSearcher;
+    parallelSearcher.setParallel(true);
+    QCOMPARE(parallelSearcher.search(searchString, m_rootGroup), expected);
+}
@@ -28,6 +28,7 @@ class TestEntrySearcher : public QObject
     Q_OBJECT
 
 private slots:
+    void initTestCase();
     void init();
     void cleanup();
 
@@ -38,6 +39,8 @@ private slots:
     void testCustomAttributesAreSearched();
     void testGroup();
     void testSkipProtected();
+    void testSearchIndex();
+    void testParallelSearch();
 
 private:
     Group* m_rootGroup;
@@ -23,8 +23,10 @@
 #include <QSignalSpy>
 #include <QtTestGui>
 
+#include "core/EntryReferenceIndex.h"
 #include "core/Group.h"
 #include "core/Metadata.h"
+#include "core/Tools.h"
 #include "crypto/Crypto.h"
 
 QTEST_GUILESS_MAIN(TestGroup)
@@ -554,6 +556,60 @@ void TestGroup::testFindEntry()
     QVERIFY(!entry);
 }
 
+void TestGroup::testFindByUuid()
+{
+    QScopedPointer<Database> db(new Database());
+    QScopedPointer<Database> db2(new Database());
+
+    auto* group1 = new Group();
+    group1->setUuid(QUuid::createUuid());
+    group1->setParent(db->rootGroup());
+
+    auto* group2 = new Group();
+    group2->setUuid(QUuid::createUuid());
+    group2->setParent(group1);
+
+    auto* entry1 = new Entry();
+    entry1->setUuid(QUuid::createUuid());
+    entry1->setGroup(group2);
+
+    // Lookups are limited to the group they are called on
+    QCOMPARE(db->rootGroup()->findEntryByUuid(entry1->uuid()), entry1);
+    QCOMPARE(group1->findEntryByUuid(entry1->uuid()), entry1);
+    QVERIFY(!group1->findEntryByUuid(entry1->uuid(), false));
+    QCOMPARE(group2->findEntryByUuid(entry1->uuid(), false), entry1);
+    QCOMPARE(db->rootGroup()->findGroupByUuid(group2->uuid()), group2);
+    QCOMPARE(group2->findGroupByUuid(group2->uuid()), group2);
+    QVERIFY(!group2->findGroupByUuid(group1->uuid()));
+
+    // Changed UUIDs are picked up
+    const QUuid oldUuid = entry1->uuid();
+    entry1->setUuid(QUuid::createUuid());
+    QVERIFY(!db->rootGroup()->findEntryByUuid(oldUuid));
+    QCOMPARE(db->rootGroup()->findEntryByUuid(entry1->uuid()), entry1);
+    QCOMPARE(db->rootGroup()->findEntryBySearchTerm(entry1->uuidToHex(), EntryReferenceType::QUuid), entry1);
+
+    // Moving a group to another database moves its contents as well
+    group1->setParent(db2->rootGroup());
+    QVERIFY(!db->rootGroup()->findEntryByUuid(entry1->uuid()));
+    QVERIFY(!db->rootGroup()->findGroupByUuid(group2->uuid()));
+    QCOMPARE(db2->rootGroup()->findEntryByUuid(entry1->uuid()), entry1);
+    QCOMPARE(db2->rootGroup()->findGroupByUuid(group2->uuid()), group2);
+
+    // Duplicate UUIDs resolve to the first match in tree order
+    auto* entry2 = entry1->clone(Entry::CloneNoFlags);
+    entry2->setGroup(db2->rootGroup());
+    QCOMPARE(db2->rootGroup()->findEntryByUuid(entry1->uuid()), entry2);
+    QCOMPARE(group2->findEntryByUuid(entry1->uuid()), entry1);
+
+    const QUuid entryUuid = entry1->uuid();
+    const QUuid groupUuid = group2->uuid();
+    delete entry2;
+    delete group1;
+    QVERIFY(!db2->rootGroup()->findEntryByUuid(entryUuid));
+    QVERIFY(!db2->rootGroup()->findGroupByUuid(groupUuid));
+}
+
 void TestGroup::testFindGroupByPath()
 {
     QScopedPointer<Database> db(new Database());
@@ -616,6 +672,56 @@ void TestGroup::testFindGroupByPath()
     QVERIFY(!group);
 }
 
+void TestGroup::testFindByPathAfterChanges()
+{
+    QScopedPointer<Database> db(new Database());
+
+    Group* group1 = new Group();
+    group1->setName("group1");
+    group1->setParent(db->rootGroup());
+
+    Group* group2 = new Group();
+    group2->setName("group2");
+    group2->setParent(group1);
+
+    Entry* entry1 = new Entry();
+    entry1->setTitle("entry");
+    entry1->setGroup(group1);
+
+    Entry* entry2 = new Entry();
+    entry2->setTitle("entry");
+    entry2->setGroup(group2);
+
+    QCOMPARE(db->rootGroup()->findGroupByPath("/group1/group2"), group2);
+    QCOMPARE(db->rootGroup()->findEntryByPath("/group1/entry"), entry1);
+    QCOMPARE(db->rootGroup()->findEntryByPath("group1/group2/entry"), entry2);
+    // The first entry in tree order wins
+    QCOMPARE(db->rootGroup()->findEntryByPath("entry"), entry1);
+
+    group1->setName("renamed");
+    QVERIFY(!db->rootGroup()->findGroupByPath("/group1"));
+    QCOMPARE(db->rootGroup()->findGroupByPath("/renamed/group2"), group2);
+    QCOMPARE(db->rootGroup()->findEntryByPath("/renamed/entry"), entry1);
+
+    entry1->setTitle("other");
+    QVERIFY(!db->rootGroup()->findEntryByPath("/renamed/entry"));
+    QCOMPARE(db->rootGroup()->findEntryByPath("/renamed/other"), entry1);
+    QCOMPARE(db->rootGroup()->findEntryByPath("entry"), entry2);
+
+    group2->setParent(db->rootGroup());
+    QVERIFY(!db->rootGroup()->findGroupByPath("/renamed/group2"));
+    QCOMPARE(db->rootGroup()->findGroupByPath("/group2"), group2);
+    QCOMPARE(db->rootGroup()->findEntryByPath("/group2/entry"), entry2);
+
+    entry1->setGroup(group2);
+    QVERIFY(!db->rootGroup()->findEntryByPath("/renamed/other"));
+    QCOMPARE(db->rootGroup()->findEntryByPath("/group2/other"), entry1);
+
+    delete group2;
+    QVERIFY(!db->rootGroup()->findGroupByPath("/group2"));
+    QVERIFY(!db->rootGroup()->findEntryByPath("entry"));
+}
+
 void TestGroup::testPrint()
 {
     QScopedPointer<Database> db(new Database());
@@ -1293,3 +1399,68 @@ void TestGroup::testPreviousParentGroup()
     QVERIFY(group1->previousParentGroupUuid() == group2->uuid());
     QVERIFY(group1->previousParentGroup() == group2);
 }
+
+void TestGroup::testReferencesRecursive()
+{
+    Database db;
+    auto* root = db.rootGroup();
+    auto* group = new Group();
+    group->setParent(root);
+
+    auto* target = new Entry();
+    target->setUuid(QUuid::createUuid());
+    target->setGroup(root);
+    target->setPassword("secret");
+
+    const QString reference = QString("{REF:P@I:%1}").arg(Tools::uuidToHex(target->uuid()));
+    auto* referrer1 = new Entry();
+    referrer1->setUuid(QUuid::createUuid());
+    referrer1->setGroup(root);
+    referrer1->setPassword(reference);
+    auto* referrer2 = new Entry();
+    referrer2->setUuid(QUuid::createUuid());
+    referrer2->setGroup(group);
+    referrer2->setUsername(reference.toUpper());
+    auto* unrelated = new Entry();
+    unrelated->setUuid(QUuid::createUuid());
+    unrelated->setGroup(group);
+    unrelated->setNotes(Tools::uuidToHex(target->uuid()));
+
+    auto references = root->referencesRecursive(target);
+    QCOMPARE(references.size(), 2);
+    QVERIFY(references.contains(referrer1));
+    QVERIFY(references.contains(referrer2));
+    QCOMPARE(group->referencesRecursive(target), QList<Entry*>({referrer2}));
+    QVERIFY(root->referencesRecursive(referrer1).isEmpty());
+
+    // The index follows changes of the entries and the tree
+    referrer1->setPassword("plain");
+    QCOMPARE(root->referencesRecursive(target), QList<Entry*>({referrer2}));
+    unrelated->setPassword(QString("{REF:U@I:%1}").arg(Tools::uuidToHex(target->uuid())));
+    references = root->referencesRecursive(target);
+    QCOMPARE(references.size(), 2);
+    QVERIFY(references.contains(referrer2));
+    QVERIFY(references.contains(unrelated));
+    delete unrelated;
+    QCOMPARE(root->referencesRecursive(target), QList<Entry*>({referrer2}));
+    referrer2->setGroup(root);
+    QVERIFY(group->referencesRecursive(target).isEmpty());
+
+    // Blocking modified signals, as saving does, keeps the index
+    db.setEmitModified(false);
+    db.setEmitModified(true);
+    QVERIFY(db.entryReferenceIndex()->isBuilt());
+
+    // Changes made while blocked are picked up from the attribute signals
+    db.setEmitModified(false);
+    referrer1->setPassword(reference);
+    QCOMPARE(root->referencesRecursive(target).size(), 2);
+    db.setEmitModified(true);
+    QCOMPARE(root->referencesRecursive(target).size(), 2);
+    referrer1->setPassword("plain");
+
+    // Every check agrees with the entries themselves
+    for (auto* entry : root->entriesRecursive()) {
+        QCOMPARE(root->referencesRecursive(target).contains(entry), entry->hasReferencesTo(target->uuid()));
+    }
+}
@@ -37,7 +37,9 @@ private slots:
     void testClone();
     void testCopyCustomIcons();
     void testFindEntry();
+    void testFindByUuid();
     void testFindGroupByPath();
+    void testFindByPathAfterChanges();
     void testPrint();
     void testAddEntryWithPath();
     void testIsRecycled();
@@ -49,6 +51,7 @@ private slots:
     void testUsernamesRecursive();
     void testMoveUpDown();
     void testPreviousParentGroup();
+    void testReferencesRecursive();
 };
 
 #endif // KEEPASSX_TESTGROUP_H
@@ -24,6 +24,7 @@
 #include <QBuffer>
 #include <QByteArray>
 #include <QList>
+#include <QTemporaryFile>
 #include <QTest>
 
 QTEST_GUILESS_MAIN(TestHibp)
@@ -31,6 +32,12 @@ QTEST_GUILESS_MAIN(TestHibp)
 const char* TEST_HIBP_CONTENTS = "0BEEC7B5EA3F0FDBC95D0DD47F3C5BC275DA8A33:123\n" // SHA-1 of "foo"
                                  "62cdb7020ff920e5aa642c3d4066950dd1f01f4d:456\n"; // SHA-1 of "bar"
 
+const char* TEST_SORTED_HIBP_CONTENTS = "000000005AD76BD555C1D6D771DE417A4B87E4B4:4\r\n"
+                                        "0BEEC7B5EA3F0FDBC95D0DD47F3C5BC275DA8A33:123\r\n" // SHA-1 of "foo"
+                                        "3C3E1A2B8BD0A0EB1AA4BC0D4D4D2E5B44B1A1E0:7\r\n"
+                                        "62CDB7020FF920E5AA642C3D4066950DD1F01F4D:456\r\n" // SHA-1 of "bar"
+                                        "FFFFFFFFDD7F2A1C68A35673713783CA390C9E93:630\r\n";
+
 const char* TEST_BAD_HIBP_CONTENTS = "barf:nope\n";
 
 void TestHibp::initTestCase()
@@ -118,3 +125,74 @@ void TestHibp::testPwned()
     QCOMPARE(findings[1].first, entry4);
     QCOMPARE(findings[1].second, 456);
 }
+
+void TestHibp::testPwnedMappedFile()
+{
+    QTemporaryFile hibpFile;
+    QVERIFY(hibpFile.open());
+    QVERIFY(hibpFile.write(TEST_SORTED_HIBP_CONTENTS) > 0);
+    hibpFile.close();
+
+    Group* root = m_db->rootGroup();
+
+    Entry* entry1 = new Entry();
+    entry1->setPassword("bar");
+    entry1->setGroup(root);
+
+    Entry* entry2 = new Entry();
+    entry2->setPassword("xyz");
+    entry2->setGroup(root);
+
+    Entry* entry3 = new Entry();
+    entry3->setPassword("foo");
+    entry3->setGroup(root);
+
+    QList<QPair<const Entry*, int>> findings;
+    QString error;
+    QVERIFY(HibpOffline::report(m_db, hibpFile.fileName(), findings, &error));
+    QCOMPARE(error, QString());
+    QCOMPARE(findings.size(), 2);
+    QCOMPARE(findings[0].first, entry3);
+    QCOMPARE(findings[0].second, 123);
+    QCOMPARE(findings[1].first, entry1);
+    QCOMPARE(findings[1].second, 456);
+
+    // Missing files are reported
+    findings.clear();
+    QVERIFY(!HibpOffline::report(m_db, hibpFile.fileName() + ".missing", findings, &error));
+    QVERIFY(!error.isEmpty());
+    QCOMPARE(findings.size(), 0);
+}
+
+void TestHibp::testUnsortedMappedFile()
+{
+    // Files that are not ordered by hash fall back to a full scan
+    QTemporaryFile hibpFile;
+    QVERIFY(hibpFile.open());
+    QVERIFY(hibpFile.write("FFFFFFFFDD7F2A1C68A35673713783CA390C9E93:630\n") > 0);
+    QVERIFY(hibpFile.write(TEST_HIBP_CONTENTS) > 0);
+    hibpFile.close();
+
+    Entry* entry1 = new Entry();
+    entry1->setPassword("foo");
+    entry1->setGroup(m_db->rootGroup());
+
+    QList<QPair<const Entry*, int>> findings;
+    QString error;
+    QVERIFY(HibpOffline::report(m_db, hibpFile.fileName(), findings, &error));
+    QCOMPARE(error, QString());
+    QCOMPARE(findings.size(), 1);
+    QCOMPARE(findings[0].first, entry1);
+    QCOMPARE(findings[0].second, 123);
+
+    // Malformed files are still rejected by the sequential parser
+    QVERIFY(hibpFile.open());
+    hibpFile.resize(0);
+    QVERIFY(hibpFile.write(TEST_BAD_HIBP_CONTENTS) > 0);
+    hibpFile.close();
+
+    findings.clear();
+    QVERIFY(!HibpOffline::report(m_db, hibpFile.fileName(), findings, &error));
+    QVERIFY(!error.isEmpty());
+    QCOMPARE(findings.size(), 0);
+}
@@ -34,6 +34,8 @@ private slots:
     void testEmpty();
     void testIoError();
     void testPwned();
+    void testPwnedMappedFile();
+    void testUnsortedMappedFile();
 
 private:
     QSharedPointer<Database> m_db;
@@ -0,0 +1,202 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestHmacDecryptStream.h"
+
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include "core/Endian.h"
+#include "crypto/Crypto.h"
+#include "crypto/Random.h"
+#include "streams/HmacBlockStream.h"
+#include "streams/HmacDecryptStream.h"
+#include "streams/SymmetricCipherStream.h"
+#include "streams/qtiocompressor.h"
+#include "util/HmacStreamTestData.h"
+
+#include <limits>
+
+QTEST_GUILESS_MAIN(TestHmacDecryptStream)
+
+using namespace HmacStreamTestData;
+
+namespace
+{
+    // Writes data the same way Kdbx4Writer writes the payload
+    void writePayload(QIODevice* device,
+                      SymmetricCipher::Mode mode,
+                      int hmacBlockSize,
+                      bool compressed,
+                      const QByteArray& iv,
+                      const QByteArray& data)
+    {
+        HmacBlockStream hmacStream(device, HmacKey, hmacBlockSize);
+        QVERIFY(hmacStream.open(QIODevice::WriteOnly));
+        SymmetricCipherStream cipherStream(&hmacStream);
+        QVERIFY(cipherStream.init(mode, SymmetricCipher::Encrypt, Key, iv));
+        QVERIFY(cipherStream.open(QIODevice::WriteOnly));
+
+        if (compressed) {
+            QtIOCompressor compressor(&cipherStream);
+            compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+            QVERIFY(compressor.open(QIODevice::WriteOnly));
+            QCOMPARE(compressor.write(data), qint64(data.size()));
+            compressor.close();
+        } else {
+            QCOMPARE(cipherStream.write(data), qint64(data.size()));
+        }
+        QVERIFY(cipherStream.reset());
+        QVERIFY(hmacStream.reset());
+    }
+} // namespace
+
+void TestHmacDecryptStream::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestHmacDecryptStream::testRead_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<SymmetricCipher::Mode>("mode");
+    QTest::addColumn<int>("hmacBlockSize");
+    QTest::addColumn<bool>("compressed");
+    QTest::addColumn<int>("size");
+
+    for (int threads : {1, 4}) {
+        addRow("AES, compressed", threads) << SymmetricCipher::Aes256_CBC << 1024 * 1024 << true << 3000000;
+        addRow("AES, uncompressed", threads) << SymmetricCipher::Aes256_CBC << 1024 * 1024 << false << 3000000;
+        addRow("AES, aligned size", threads) << SymmetricCipher::Aes256_CBC << 1024 * 1024 << false << 1024 * 1024;
+        addRow("AES, unaligned blocks", threads) << SymmetricCipher::Aes256_CBC << 1000 << false << 100000;
+        addRow("AES, empty", threads) << SymmetricCipher::Aes256_CBC << 1024 * 1024 << false << 0;
+        addRow("AES-CTR, unaligned blocks", threads) << SymmetricCipher::Aes256_CTR << 1000 << true << 100000;
+        addRow("Twofish, unaligned blocks", threads) << SymmetricCipher::Twofish_CBC << 33 << true << 100000;
+        addRow("ChaCha20, compressed", threads) << SymmetricCipher::ChaCha20 << 1024 * 1024 << true << 3000000;
+        addRow("ChaCha20, unaligned blocks", threads) << SymmetricCipher::ChaCha20 << 1000 << false << 100000;
+    }
+}
+
+void TestHmacDecryptStream::testRead()
+{
+    QFETCH(SymmetricCipher::Mode, mode);
+    QFETCH(int, hmacBlockSize);
+    QFETCH(bool, compressed);
+    QFETCH(int, size);
+    QFETCH(int, threads);
+
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(mode));
+    const QByteArray data = payload(size);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    writePayload(&buffer, mode, hmacBlockSize, compressed, iv, data);
+    buffer.reset();
+
+    HmacDecryptStream reader(&buffer, HmacKey);
+    reader.setMaxThreadCount(threads);
+    QVERIFY(reader.init(mode, Key, iv, compressed));
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+
+    // Read in odd sized chunks to cross block boundaries
+    QByteArray result;
+    QByteArray chunk;
+    do {
+        chunk = reader.read(4099);
+        result.append(chunk);
+    } while (!chunk.isEmpty());
+
+    QCOMPARE(reader.errorString(), QString());
+    QCOMPARE(result.size(), data.size());
+    QVERIFY(result == data);
+}
+
+void TestHmacDecryptStream::testReadFile()
+{
+    const auto mode = SymmetricCipher::Aes256_CBC;
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(mode));
+    const QByteArray data = payload(3000000);
+    const QByteArray prefix("header");
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(prefix), qint64(prefix.size()));
+    writePayload(&file, mode, 1024 * 1024, true, iv, data);
+    QCOMPARE(file.write("trailer"), qint64(7));
+    QVERIFY(file.seek(prefix.size()));
+
+    QByteArray result;
+    {
+        HmacDecryptStream reader(&file, HmacKey);
+        QVERIFY(reader.init(mode, Key, iv, true));
+        QVERIFY(reader.open(QIODevice::ReadOnly));
+        result = reader.readAll();
+        QCOMPARE(reader.errorString(), QString());
+    }
+    QVERIFY(result == data);
+
+    // The file itself is untouched and positioned after the payload
+    QCOMPARE(file.readAll(), QByteArray("trailer"));
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.read(prefix.size()), prefix);
+}
+
+void TestHmacDecryptStream::testTamperedBlock()
+{
+    const auto mode = SymmetricCipher::ChaCha20;
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(mode));
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    writePayload(&buffer, mode, 1000, false, iv, payload(5000));
+
+    // Flip a bit inside the data of the third block
+    buffer.buffer().data()[2 * (32 + 4 + 1000) + 32 + 4 + 10] ^= 1;
+    buffer.reset();
+
+    HmacDecryptStream reader(&buffer, HmacKey);
+    QVERIFY(reader.init(mode, Key, iv, false));
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QCOMPARE(reader.read(2000).size(), 2000);
+    QCOMPARE(reader.read(1000), QByteArray());
+    QCOMPARE(reader.errorString(), QString("Mismatch between hash and data."));
+}
+
+void TestHmacDecryptStream::testInvalidBlockSize()
+{
+    const auto mode = SymmetricCipher::Aes256_CBC;
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(mode));
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    writePayload(&buffer, mode, 1000, false, iv, payload(5000));
+
+    // The first block leaves 8 bytes of cipher text for the second one,
+    // which claims to be as large as possible
+    const QByteArray size = Endian::sizedIntToBytes<qint32>(std::numeric_limits<qint32>::max(), QSysInfo::LittleEndian);
+    buffer.buffer().replace(32 + 4 + 1000 + 32, 4, size);
+    buffer.reset();
+
+    HmacDecryptStream reader(&buffer, HmacKey);
+    reader.setMaxThreadCount(1);
+    QVERIFY(reader.init(mode, Key, iv, false));
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QCOMPARE(reader.read(992).size(), 992);
+    QCOMPARE(reader.read(1), QByteArray());
+    QCOMPARE(reader.errorString(), QString("Invalid block size."));
+}
@@ -0,0 +1,176 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestHmacEncryptStream.h"
+
+#include <QBuffer>
+#include <QTest>
+
+#include "FailDevice.h"
+#include "crypto/Crypto.h"
+#include "crypto/Random.h"
+#include "streams/HmacBlockStream.h"
+#include "streams/HmacDecryptStream.h"
+#include "streams/HmacEncryptStream.h"
+#include "streams/SymmetricCipherStream.h"
+#include "streams/qtiocompressor.h"
+#include "util/HmacStreamTestData.h"
+
+QTEST_GUILESS_MAIN(TestHmacEncryptStream)
+
+using namespace HmacStreamTestData;
+
+namespace
+{
+    // Reads data the same way Kdbx4Reader used to read the payload
+    QByteArray readPayload(QIODevice* device, SymmetricCipher::Mode mode, bool compressed, const QByteArray& iv)
+    {
+        HmacBlockStream hmacStream(device, HmacKey);
+        hmacStream.open(QIODevice::ReadOnly);
+        SymmetricCipherStream cipherStream(&hmacStream);
+        if (!cipherStream.init(mode, SymmetricCipher::Decrypt, Key, iv)) {
+            return {};
+        }
+        cipherStream.open(QIODevice::ReadOnly);
+
+        if (compressed) {
+            QtIOCompressor compressor(&cipherStream);
+            compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+            compressor.open(QIODevice::ReadOnly);
+            return compressor.readAll();
+        }
+        return cipherStream.readAll();
+    }
+} // namespace
+
+void TestHmacEncryptStream::initTestCase()
+{
+    QVERIFY(Crypto::init());
+}
+
+void TestHmacEncryptStream::testWrite_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<SymmetricCipher::Mode>("mode");
+    QTest::addColumn<bool>("compressed");
+    QTest::addColumn<int>("size");
+
+    for (int threads : {1, 4}) {
+        addRow("AES, compressed", threads) << SymmetricCipher::Aes256_CBC << true << 3000000;
+        addRow("AES, uncompressed", threads) << SymmetricCipher::Aes256_CBC << false << 3000000;
+        addRow("AES, aligned size", threads) << SymmetricCipher::Aes256_CBC << false << 2 * 1024 * 1024;
+        addRow("AES, empty", threads) << SymmetricCipher::Aes256_CBC << true << 0;
+        addRow("AES-CTR, uncompressed", threads) << SymmetricCipher::Aes256_CTR << false << 3000000;
+        addRow("Twofish, compressed", threads) << SymmetricCipher::Twofish_CBC << true << 1000000;
+        addRow("ChaCha20, compressed", threads) << SymmetricCipher::ChaCha20 << true << 3000000;
+        addRow("ChaCha20, uncompressed", threads) << SymmetricCipher::ChaCha20 << false << 3000000;
+        addRow("ChaCha20, small", threads) << SymmetricCipher::ChaCha20 << false << 100;
+    }
+}
+
+void TestHmacEncryptStream::testWrite()
+{
+    QFETCH(SymmetricCipher::Mode, mode);
+    QFETCH(bool, compressed);
+    QFETCH(int, size);
+    QFETCH(int, threads);
+
+    const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(mode));
+    const QByteArray data = payload(size);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    {
+        HmacEncryptStream writer(&buffer, HmacKey);
+        writer.setMaxThreadCount(threads);
+        QVERIFY(writer.init(mode, Key, iv, compressed));
+        QVERIFY(writer.open(QIODevice::WriteOnly));
+
+        // Write in odd sized pieces like the XML writer does
+        for (int pos = 0; pos < data.size(); pos += 1021) {
+            QByteArray piece = data.mid(pos, 1021);
+            QCOMPARE(writer.write(piece), qint64(piece.size()));
+        }
+        QVERIFY(writer.reset());
+        QVERIFY(writer.reset());
+    }
+
+    if (!compressed) {
+        // Without compression the output is identical to the sequential stream chain
+        QBuffer expected;
+        QVERIFY(expected.open(QIODevice::ReadWrite));
+        HmacBlockStream hmacStream(&expected, HmacKey);
+        QVERIFY(hmacStream.open(QIODevice::WriteOnly));
+        SymmetricCipherStream cipherStream(&hmacStream);
+        QVERIFY(cipherStream.init(mode, SymmetricCipher::Encrypt, Key, iv));
+        QVERIFY(cipherStream.open(QIODevice::WriteOnly));
+        QCOMPARE(cipherStream.write(data), qint64(data.size()));
+        QVERIFY(cipherStream.reset());
+        QVERIFY(hmacStream.reset());
+        QVERIFY(expected.buffer() == buffer.buffer());
+    }
+
+    buffer.reset();
+    QByteArray result = readPayload(&buffer, mode, compressed, iv);
+    QCOMPARE(result.size(), data.size());
+    QVERIFY(result == data);
+}
+
+void TestHmacEncryptStream::testWriteEmpty()
+{
+    for (auto mode : {SymmetricCipher::Aes256_CBC, SymmetricCipher::ChaCha20}) {
+        for (bool compressed : {false, true}) {
+            const QByteArray iv = randomGen()->randomArray(SymmetricCipher::defaultIvSize(mode));
+
+            QBuffer buffer;
+            QVERIFY(buffer.open(QIODevice::ReadWrite));
+            {
+                HmacEncryptStream writer(&buffer, HmacKey);
+                QVERIFY(writer.init(mode, Key, iv, compressed));
+                QVERIFY(writer.open(QIODevice::WriteOnly));
+                QVERIFY(writer.reset());
+            }
+            // The final block is written even without any data
+            QVERIFY(!buffer.buffer().isEmpty());
+
+            buffer.reset();
+            HmacDecryptStream reader(&buffer, HmacKey);
+            QVERIFY(reader.init(mode, Key, iv, compressed));
+            QVERIFY(reader.open(QIODevice::ReadOnly));
+            QCOMPARE(reader.readAll(), QByteArray());
+            QCOMPARE(reader.errorString(), QString());
+            QVERIFY(reader.atEnd());
+        }
+    }
+}
+
+void TestHmacEncryptStream::testWriteFailure()
+{
+    FailDevice failDevice(1500000);
+    QVERIFY(failDevice.open(QIODevice::WriteOnly));
+
+    HmacEncryptStream writer(&failDevice, HmacKey);
+    QVERIFY(writer.init(SymmetricCipher::ChaCha20, Key, QByteArray(12, 0), false));
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+
+    QByteArray data(1024 * 1024, 'Z');
+    for (int i = 0; i < 2; ++i) {
+        writer.write(data);
+    }
+    QVERIFY(!writer.reset());
+    QCOMPARE(writer.errorString(), QString("FAILDEVICE"));
+}
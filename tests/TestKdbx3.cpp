@@ -18,13 +18,17 @@
 #include "TestKdbx3.h"
 
 #include "config-keepassx-tests.h"
+#include "core/Group.h"
 #include "core/Metadata.h"
+#include "crypto/Random.h"
 #include "format/KdbxXmlReader.h"
 #include "format/KdbxXmlWriter.h"
 #include "format/KeePass2.h"
 #include "format/KeePass2Reader.h"
 #include "format/KeePass2Writer.h"
 #include "keys/PasswordKey.h"
+#include <QBuffer>
+#include <QFile>
 #include <QTest>
 
 QTEST_GUILESS_MAIN(TestKdbx3)
@@ -133,6 +137,62 @@ void TestKdbx3::testCompressed()
     QCOMPARE(db->compressionAlgorithm(), Database::CompressionGZip);
 }
 
+void TestKdbx3::testLargeAttachments()
+{
+    // Larger than the slices the reader decodes at once
+    const QByteArray random = randomGen()->randomArray(1024 * 1024 + 7);
+    const QByteArray repeated(3 * 1024 * 1024, 'x');
+
+    for (auto compression : {Database::CompressionNone, Database::CompressionGZip}) {
+        Database db;
+        db.setCompressionAlgorithm(compression);
+        auto entry = new Entry();
+        entry->setParent(db.rootGroup());
+        entry->attachments()->set("random.bin", random);
+        entry->attachments()->set("repeated.txt", repeated);
+        entry->attachments()->set("empty", QByteArray());
+
+        QBuffer buffer;
+        buffer.open(QBuffer::ReadWrite);
+        bool hasError;
+        QString errorString;
+        writeXml(&buffer, &db, hasError, errorString);
+        QVERIFY2(!hasError, qPrintable(errorString));
+
+        buffer.seek(0);
+        auto readDb = readXml(&buffer, true, hasError, errorString);
+        QVERIFY2(!hasError, qPrintable(errorString));
+        QVERIFY(readDb);
+
+        auto readEntry = readDb->rootGroup()->entries().at(0);
+        QCOMPARE(readEntry->attachments()->value("random.bin"), random);
+        QCOMPARE(readEntry->attachments()->value("repeated.txt"), repeated);
+        QCOMPARE(readEntry->attachments()->value("empty"), QByteArray());
+    }
+}
+
+void TestKdbx3::testBrokenCompressedAttachment()
+{
+    QFile file(QString(KEEPASSX_TEST_DATA_DIR).append("/NewDatabase.xml"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray xml = file.readAll();
+
+    // Replace the first binary with base64 data that is not gzipped
+    const int start = xml.indexOf("<Binary ID=\"0\" Compressed=\"True\">");
+    QVERIFY(start >= 0);
+    const int end = xml.indexOf("</Binary>", start);
+    xml.replace(start, end - start, "<Binary ID=\"0\" Compressed=\"True\">bm90IGd6aXBwZWQ=");
+
+    QBuffer buffer(&xml);
+    buffer.open(QBuffer::ReadOnly);
+
+    bool hasError;
+    QString errorString;
+    readXml(&buffer, false, hasError, errorString);
+    QVERIFY(hasError);
+    QCOMPARE(errorString, QString("Unable to decompress binary"));
+}
+
 void TestKdbx3::testProtectedStrings()
 {
     QString filename = QString(KEEPASSX_TEST_DATA_DIR).append("/ProtectedStrings.kdbx");
@@ -27,6 +27,8 @@ class TestKdbx3 : public TestKeePass2Format
 private slots:
     void testNonAscii();
     void testCompressed();
+    void testLargeAttachments();
+    void testBrokenCompressedAttachment();
     void testProtectedStrings();
     void testBrokenHeaderHash();
     void testFormat300();
@@ -87,3 +87,64 @@ void TestKeePass2RandomStream::test()
     QCOMPARE(cipherData, cipherDataEncrypt);
     QCOMPARE(randomStreamData, cipherData);
 }
+
+void TestKeePass2RandomStream::testLargeData()
+{
+    const QByteArray key("\x11\x22\x33\x44\x55\x66\x77\x88");
+
+    // Mix small values with ones that exceed the internal keystream buffer
+    QByteArray data;
+    const QList<int> sizes({3, 5000, 1, 4095, 4096, 17, 70000, 0, 9});
+    for (int i = 0; i < 90000; ++i) {
+        data.append(static_cast<char>(i * 31));
+    }
+
+    SymmetricCipher cipher;
+    QVERIFY(cipher.init(SymmetricCipher::ChaCha20,
+                        SymmetricCipher::Encrypt,
+                        CryptoHash::hash(key, CryptoHash::Sha512).left(32),
+                        CryptoHash::hash(key, CryptoHash::Sha512).mid(32, 12)));
+    QByteArray expected = data;
+    QVERIFY(cipher.process(expected));
+
+    KeePass2RandomStream randomStream;
+    QVERIFY(randomStream.init(SymmetricCipher::ChaCha20, key));
+
+    QByteArray actual;
+    int offset = 0;
+    bool ok;
+    for (int size : sizes) {
+        actual.append(randomStream.process(data.mid(offset, size), &ok));
+        QVERIFY(ok);
+        offset += size;
+    }
+    QByteArray rest = data.mid(offset);
+    QVERIFY(randomStream.processInPlace(rest));
+    actual.append(rest);
+
+    QCOMPARE(actual.size(), expected.size());
+    QCOMPARE(actual, expected);
+}
+
+void TestKeePass2RandomStream::benchmarkProcess()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    // Typical protected values are short passwords, processed one after another
+    const QByteArray key(32, '\x4B');
+    QByteArray value(24, '\x42');
+
+    KeePass2RandomStream randomStream;
+    QVERIFY(randomStream.init(SymmetricCipher::ChaCha20, key));
+
+    QBENCHMARK
+    {
+        for (int i = 0; i < 10000; ++i) {
+            Q_UNUSED(!randomStream.processInPlace(value));
+        }
+    };
+}
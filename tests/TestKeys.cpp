@@ -19,18 +19,25 @@
 #include "TestKeys.h"
 
 #include <QBuffer>
+#include <QElapsedTimer>
 #include <QTest>
+#include <QThread>
+
+#include <argon2.h>
 
 #include "config-keepassx-tests.h"
 
+#include "core/Config.h"
 #include "core/Database.h"
 #include "core/Metadata.h"
 #include "crypto/Crypto.h"
 #include "crypto/CryptoHash.h"
 #include "crypto/kdf/AesKdf.h"
+#include "crypto/kdf/Argon2Kdf.h"
 #include "format/KeePass2Reader.h"
 #include "format/KeePass2Writer.h"
 #include "keys/CompositeKey.h"
+#include "keys/DerivedKeyCache.h"
 #include "keys/FileKey.h"
 #include "keys/PasswordKey.h"
 #include "mock/MockChallengeResponseKey.h"
@@ -41,6 +48,7 @@ Q_DECLARE_METATYPE(FileKey::Type);
 void TestKeys::initTestCase()
 {
     QVERIFY(Crypto::init());
+    Config::createTempFileInstance();
 }
 
 void TestKeys::testComposite()
@@ -327,3 +335,130 @@ void TestKeys::testCompositeKeyComponents()
     QVERIFY(!reader.readDatabase(&buffer, compositeKeyDec4, db2.data()));
     QVERIFY(reader.hasError());
 }
+
+void TestKeys::testArgon2Lanes()
+{
+    QFETCH(int, type);
+    QFETCH(int, version);
+    QFETCH(int, lanes);
+    QFETCH(int, memory);
+    QFETCH(int, rounds);
+
+    Argon2Kdf kdf(type == Argon2_d ? Argon2Kdf::Type::Argon2d : Argon2Kdf::Type::Argon2id);
+    QVERIFY(kdf.setVersion(static_cast<quint32>(version)));
+    QVERIFY(kdf.setParallelism(static_cast<quint32>(lanes)));
+    QVERIFY(kdf.setMemory(static_cast<quint64>(memory)));
+    QVERIFY(kdf.setRounds(rounds));
+    QVERIFY(kdf.setSeed(QByteArray(32, '\x4B')));
+
+    const QByteArray password("password");
+    QByteArray result;
+    QVERIFY(kdf.transform(password, result));
+
+    // The lanes run on our own thread pool, the tag has to match the reference implementation
+    QByteArray expected(32, '\0');
+    const QByteArray seed = kdf.seed();
+    QCOMPARE(argon2_hash(static_cast<quint32>(rounds),
+                         static_cast<quint32>(memory),
+                         static_cast<quint32>(lanes),
+                         password.data(),
+                         password.size(),
+                         seed.data(),
+                         seed.size(),
+                         expected.data(),
+                         expected.size(),
+                         nullptr,
+                         0,
+                         static_cast<argon2_type>(type),
+                         static_cast<quint32>(version)),
+             static_cast<int>(ARGON2_OK));
+    QCOMPARE(result.toHex(), expected.toHex());
+}
+
+void TestKeys::testArgon2Lanes_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<int>("version");
+    QTest::addColumn<int>("lanes");
+    QTest::addColumn<int>("memory");
+    QTest::addColumn<int>("rounds");
+
+    QTest::newRow("Argon2d v1.3, 1 lane") << int(Argon2_d) << 0x13 << 1 << 64 << 3;
+    QTest::newRow("Argon2d v1.3, 4 lanes") << int(Argon2_d) << 0x13 << 4 << 1024 << 2;
+    QTest::newRow("Argon2d v1.0, 3 lanes") << int(Argon2_d) << 0x10 << 3 << 100 << 3;
+    QTest::newRow("Argon2id v1.3, 2 lanes") << int(Argon2_id) << 0x13 << 2 << 4096 << 1;
+    QTest::newRow("Argon2id v1.3, 7 lanes") << int(Argon2_id) << 0x13 << 7 << 1000 << 2;
+    QTest::newRow("Argon2id v1.0, 4 lanes") << int(Argon2_id) << 0x10 << 4 << 512 << 2;
+    QTest::newRow("Argon2id v1.3, uneven memory") << int(Argon2_id) << 0x13 << 4 << 1234 << 2;
+}
+
+void TestKeys::testArgon2Calibration()
+{
+    Argon2Kdf kdf(Argon2Kdf::Type::Argon2id);
+    const quint64 maxMemory = 1 << 14;
+    QVERIFY(kdf.calibrate(200, maxMemory));
+
+    QVERIFY(kdf.parallelism() >= 1);
+    QVERIFY(kdf.parallelism() <= static_cast<quint32>(qMax(1, QThread::idealThreadCount())));
+    QVERIFY(kdf.memory() >= 8 * kdf.parallelism());
+    QVERIFY(kdf.memory() <= maxMemory);
+    QVERIFY(kdf.rounds() >= Argon2Kdf::MIN_CALIBRATION_ROUNDS);
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray result;
+    QVERIFY(kdf.transform("password", result));
+    // Generous bound, the machine running the tests may be busy
+    QVERIFY(timer.elapsed() < 2000);
+}
+
+void TestKeys::testDerivedKeyCache()
+{
+    config()->set(Config::Security_DerivedKeyCache, true);
+
+    auto compositeKey = QSharedPointer<CompositeKey>::create();
+    compositeKey->addKey(QSharedPointer<PasswordKey>::create("password"));
+
+    AesKdf kdf;
+    kdf.setRounds(1000);
+    kdf.setSeed(QByteArray(32, '\x4B'));
+
+    QByteArray transformedKey;
+    QVERIFY(compositeKey->transform(kdf, transformedKey));
+    QVERIFY(derivedKeyCache()->storeKey("test.kdbx", *compositeKey, kdf, transformedKey));
+    QVERIFY(derivedKeyCache()->hasKey("test.kdbx"));
+
+    // Neither a different password nor a different transform seed match the cached key
+    auto wrongKey = QSharedPointer<CompositeKey>::create();
+    wrongKey->addKey(QSharedPointer<PasswordKey>::create("wrong"));
+    QByteArray result;
+    QVERIFY(!derivedKeyCache()->getKey(kdf, wrongKey->rawKey(), result));
+
+    AesKdf otherKdf;
+    otherKdf.setRounds(1000);
+    otherKdf.setSeed(QByteArray(32, '\x4C'));
+    QVERIFY(!derivedKeyCache()->getKey(otherKdf, compositeKey->rawKey(), result));
+    QVERIFY(derivedKeyCache()->hasKey("test.kdbx"));
+
+    // The transformation uses the cached key, but only once
+    kdf.setRounds(1);
+    QVERIFY(!derivedKeyCache()->getKey(kdf, compositeKey->rawKey(), result));
+    kdf.setRounds(1000);
+    QVERIFY(compositeKey->transform(kdf, result));
+    QCOMPARE(result, transformedKey);
+    QVERIFY(!derivedKeyCache()->hasKey("test.kdbx"));
+    QVERIFY(!derivedKeyCache()->getKey(kdf, compositeKey->rawKey(), result));
+
+    QVERIFY(derivedKeyCache()->storeKey("test.kdbx", *compositeKey, kdf, transformedKey));
+    derivedKeyCache()->reset("test.kdbx");
+    QVERIFY(!derivedKeyCache()->hasKey("test.kdbx"));
+
+    // Challenge-response keys have to be answered on every unlock
+    auto crKey = QSharedPointer<CompositeKey>::create();
+    crKey->addKey(QSharedPointer<PasswordKey>::create("password"));
+    crKey->addChallengeResponseKey(QSharedPointer<MockChallengeResponseKey>::create(QByteArray(16, '\x11')));
+    QVERIFY(!derivedKeyCache()->storeKey("test.kdbx", *crKey, kdf, transformedKey));
+
+    config()->set(Config::Security_DerivedKeyCache, false);
+    QVERIFY(!derivedKeyCache()->storeKey("test.kdbx", *compositeKey, kdf, transformedKey));
+}
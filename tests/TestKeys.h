@@ -35,6 +35,10 @@ private slots:
     void testFileKeyHash();
     void testFileKeyError();
     void testCompositeKeyComponents();
+    void testArgon2Lanes();
+    void testArgon2Lanes_data();
+    void testArgon2Calibration();
+    void testDerivedKeyCache();
     void benchmarkTransformKey();
 };
 
@@ -20,10 +20,20 @@
 #include "core/Global.h"
 #include "crypto/Random.h"
 
+#include <QSet>
 #include <QTest>
 
 QTEST_GUILESS_MAIN(TestRandomGenerator)
 
+namespace
+{
+    bool benchmarkEnabled()
+    {
+        QByteArray env = qgetenv("BENCHMARK");
+        return !(env.isEmpty() || env == "0" || env == "no");
+    }
+} // namespace
+
 void TestRandomGenerator::testArray()
 {
     auto ba = randomGen()->randomArray(10);
@@ -58,3 +68,56 @@ void TestRandomGenerator::testUIntRange()
         QVERIFY(rand < 200);
     }
 }
+
+void TestRandomGenerator::testBufferedUInt()
+{
+    // A small buffer has to be refilled several times during the trials
+    RandomBuffer random(16);
+    QVERIFY(random.randomUInt(0) == 0);
+    QVERIFY(random.randomUInt(1) == 0);
+
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(random.randomUInt(5) < 5);
+        QVERIFY(random.randomUInt(100) < 100);
+        QVERIFY(random.randomUInt((QUINT32_MAX / 2U) + 1U) < QUINT32_MAX / 2U + 1U);
+    }
+
+    const auto values = random.randomUInts(10, 1000);
+    QCOMPARE(values.size(), 1000);
+    QSet<quint32> seen;
+    for (quint32 value : values) {
+        QVERIFY(value < 10);
+        seen.insert(value);
+    }
+    // Every value is drawn with overwhelming probability
+    QCOMPARE(seen.size(), 10);
+
+    QVERIFY(random.randomUInts(10, 0).isEmpty());
+}
+
+void TestRandomGenerator::benchmarkUInt()
+{
+    if (!benchmarkEnabled()) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QBENCHMARK
+    {
+        for (int i = 0; i < 10000; ++i) {
+            randomGen()->randomUInt(94);
+        }
+    }
+}
+
+void TestRandomGenerator::benchmarkBufferedUInt()
+{
+    if (!benchmarkEnabled()) {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QBENCHMARK
+    {
+        RandomBuffer random;
+        random.randomUInts(94, 10000);
+    }
+}
@@ -28,6 +28,9 @@ private slots:
     void testArray();
     void testUInt();
     void testUIntRange();
+    void testBufferedUInt();
+    void benchmarkUInt();
+    void benchmarkBufferedUInt();
 };
 
 #endif // KEEPASSX_TESTRANDOMGENERATOR_H
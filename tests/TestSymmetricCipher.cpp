@@ -22,10 +22,31 @@
 #include <QTest>
 #include <QVector>
 
+#include "crypto/AesKdfKernel.h"
 #include "crypto/Crypto.h"
+#include "crypto/Random.h"
 #include "format/KeePass2.h"
 #include "streams/SymmetricCipherStream.h"
 
+#include <botan/block_cipher.h>
+
+namespace
+{
+    QByteArray botanAesKdf(const QByteArray& key, int rounds, const QByteArray& data)
+    {
+        std::unique_ptr<Botan::BlockCipher> cipher(Botan::BlockCipher::create("AES-256"));
+        cipher->set_key(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+
+        QByteArray out = data;
+        for (int i = 0; i < rounds; ++i) {
+            cipher->encrypt_n(reinterpret_cast<const uint8_t*>(out.constData()),
+                              reinterpret_cast<uint8_t*>(out.data()),
+                              out.size() / 16);
+        }
+        return out;
+    }
+} // namespace
+
 QTEST_GUILESS_MAIN(TestSymmetricCipher)
 Q_DECLARE_METATYPE(SymmetricCipher::Mode);
 Q_DECLARE_METATYPE(SymmetricCipher::Direction);
@@ -198,7 +219,71 @@ void TestSymmetricCipher::testAesKdf()
     QVERIFY(SymmetricCipher::aesKdf(key, 1, data));
     QCOMPARE(data, result);
 
-    // TODO: Test multiple rounds of AES KDF
+    for (int rounds : {0, 1, 2, 1000, 6000}) {
+        key = randomGen()->randomArray(32);
+        data = randomGen()->randomArray(32);
+        result = botanAesKdf(key, rounds, data);
+        QVERIFY(SymmetricCipher::aesKdf(key, rounds, data));
+        QCOMPARE(data, result);
+    }
+}
+
+void TestSymmetricCipher::testAesKdfKernel()
+{
+    if (!AesKdfKernel::isSupported()) {
+        QSKIP("AES-NI is not available on this CPU.");
+    }
+
+    // FIPS-197 appendix C.3
+    auto key = QByteArray::fromHex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    auto data = QByteArray::fromHex("00112233445566778899aabbccddeeff");
+    AesKdfKernel::transform(
+        reinterpret_cast<const quint8*>(key.constData()), 1, reinterpret_cast<quint8*>(data.data()), 1);
+    QCOMPARE(data, QByteArray::fromHex("8ea2b7ca516745bfeafc49904b496089"));
+
+    for (int blocks : {1, 2}) {
+        key = randomGen()->randomArray(32);
+        data = randomGen()->randomArray(16 * blocks);
+        auto expected = botanAesKdf(key, 1234, data);
+        AesKdfKernel::transform(
+            reinterpret_cast<const quint8*>(key.constData()), 1234, reinterpret_cast<quint8*>(data.data()), blocks);
+        QCOMPARE(data, expected);
+    }
+}
+
+void TestSymmetricCipher::benchmarkAesKdf_data()
+{
+    QTest::addColumn<bool>("kernel");
+    QTest::newRow("Botan") << false;
+    QTest::newRow("Kernel") << true;
+}
+
+void TestSymmetricCipher::benchmarkAesKdf()
+{
+    QByteArray env = qgetenv("BENCHMARK");
+    if (env.isEmpty() || env == "0" || env == "no") {
+        QSKIP("Benchmark skipped. Set env variable BENCHMARK=1 to enable.");
+    }
+
+    QFETCH(bool, kernel);
+    if (kernel && !AesKdfKernel::isSupported()) {
+        QSKIP("AES-NI is not available on this CPU.");
+    }
+
+    const QByteArray key(32, '\x4B');
+    QByteArray data(32, '\x7E');
+
+    QBENCHMARK
+    {
+        if (kernel) {
+            AesKdfKernel::transform(reinterpret_cast<const quint8*>(key.constData()),
+                                    1000000,
+                                    reinterpret_cast<quint8*>(data.data()),
+                                    2);
+        } else {
+            data = botanAesKdf(key, 1000000, data);
+        }
+    }
 }
 
 void TestSymmetricCipher::testTwofish256CbcEncryption()
@@ -413,6 +498,63 @@ void TestSymmetricCipher::testChaCha20()
     }
 }
 
+void TestSymmetricCipher::testStreamCipherSeek()
+{
+    const QByteArray key = QByteArray::fromHex("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4");
+    const QByteArray plainText = randomGen()->randomArray(10000);
+
+    const QList<QPair<SymmetricCipher::Mode, int>> modes{
+        {SymmetricCipher::ChaCha20, 12}, {SymmetricCipher::Aes256_CTR, 16}, {SymmetricCipher::Salsa20, 8}};
+    for (const auto& mode : modes) {
+        const QByteArray iv = randomGen()->randomArray(mode.second);
+
+        SymmetricCipher cipher;
+        QByteArray cipherText = plainText;
+        QVERIFY(cipher.init(mode.first, SymmetricCipher::Encrypt, key, iv));
+        QVERIFY(cipher.process(cipherText));
+
+        // Decrypt the second half before the first one
+        for (int offset : {4099, 0}) {
+            const int length = offset == 0 ? 4099 : cipherText.size() - offset;
+            QByteArray part = cipherText.mid(offset, length);
+            QVERIFY(cipher.init(mode.first, SymmetricCipher::Decrypt, key, iv));
+            QVERIFY(cipher.seek(offset));
+            QVERIFY(cipher.process(part));
+            QCOMPARE(part, plainText.mid(offset, length));
+        }
+    }
+
+    SymmetricCipher cipher;
+    QVERIFY(cipher.init(SymmetricCipher::Aes256_CBC, SymmetricCipher::Decrypt, key, QByteArray(16, 0)));
+    QVERIFY(!cipher.seek(16));
+}
+
+void TestSymmetricCipher::testReinitDifferentMode()
+{
+    const QByteArray key = QByteArray::fromHex("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4");
+    const QByteArray iv = QByteArray::fromHex("000102030405060708090a0b0c0d0e0f");
+    const QByteArray plainText = randomGen()->randomArray(64);
+
+    const QList<QPair<SymmetricCipher::Mode, SymmetricCipher::Mode>> modes{
+        {SymmetricCipher::ChaCha20, SymmetricCipher::Aes256_CBC},
+        {SymmetricCipher::Aes256_CBC, SymmetricCipher::Aes256_CTR}};
+    for (const auto& mode : modes) {
+        SymmetricCipher expectedCipher;
+        QByteArray expected = plainText;
+        QVERIFY(expectedCipher.init(mode.second, SymmetricCipher::Encrypt, key, iv));
+        QVERIFY(expectedCipher.process(expected));
+
+        // A cipher initialized for another mode before must not keep using it
+        SymmetricCipher cipher;
+        const QByteArray firstIv = iv.left(SymmetricCipher::defaultIvSize(mode.first));
+        QVERIFY(cipher.init(mode.first, SymmetricCipher::Encrypt, key, firstIv));
+        QByteArray cipherText = plainText;
+        QVERIFY(cipher.init(mode.second, SymmetricCipher::Encrypt, key, iv));
+        QVERIFY(cipher.process(cipherText));
+        QCOMPARE(cipherText, expected);
+    }
+}
+
 void TestSymmetricCipher::testPadding()
 {
     QByteArray key = QByteArray::fromHex("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4");
@@ -33,10 +33,15 @@ private slots:
     void testAesCbcPadding_data();
     void testAesCbcPadding();
     void testAesKdf();
+    void testAesKdfKernel();
+    void benchmarkAesKdf_data();
+    void benchmarkAesKdf();
     void testTwofish256CbcEncryption();
     void testTwofish256CbcDecryption();
     void testSalsa20();
     void testChaCha20();
+    void testStreamCipherSeek();
+    void testReinitDifferentMode();
     void testPadding();
     void testStreamReset();
 };
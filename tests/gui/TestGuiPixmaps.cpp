@@ -81,4 +81,31 @@ void TestGuiPixmaps::testGroupIcons()
     QVERIFY(Icons::groupIconPixmap(group).toImage() == Icons::customIconPixmap(db.data(), iconUuid).toImage());
 }
 
+void TestGuiPixmaps::testCustomIconCache()
+{
+    QScopedPointer<Database> db(new Database());
+
+    QUuid iconUuid = QUuid::createUuid();
+    QImage icon(1, 1, QImage::Format_RGB32);
+    icon.setPixel(0, 0, qRgb(0, 0, 50));
+    db->metadata()->addCustomIcon(iconUuid, Icons::saveToBytes(icon));
+
+    // Decoding in the background must not change the result
+    Icons::preloadCustomIcons(db.data());
+    auto pixmap = Icons::customIconPixmap(db.data(), iconUuid);
+    QVERIFY(!pixmap.isNull());
+    QCOMPARE(pixmap.toImage().pixel(0, 0), qRgb(0, 0, 50));
+
+    // The decoded pixmap is reused
+    QCOMPARE(Icons::customIconPixmap(db.data(), iconUuid).cacheKey(), pixmap.cacheKey());
+    QVERIFY(Icons::customIconPixmap(db.data(), iconUuid, IconSize::Large).cacheKey() != pixmap.cacheKey());
+
+    // Replacing the icon drops the cached pixmaps
+    db->metadata()->removeCustomIcon(iconUuid);
+    QVERIFY(Icons::customIconPixmap(db.data(), iconUuid).isNull());
+    icon.setPixel(0, 0, qRgb(50, 0, 0));
+    db->metadata()->addCustomIcon(iconUuid, Icons::saveToBytes(icon));
+    QCOMPARE(Icons::customIconPixmap(db.data(), iconUuid).toImage().pixel(0, 0), qRgb(50, 0, 0));
+}
+
 QTEST_MAIN(TestGuiPixmaps)
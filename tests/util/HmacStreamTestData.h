@@ -0,0 +1,57 @@
+/*
+ *  Copyright (C) 2022 KeePassXC Team <team@keepassxc.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 or (at your option)
+ *  version 3 of the License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASSXC_HMACSTREAMTESTDATA_H
+#define KEEPASSXC_HMACSTREAMTESTDATA_H
+
+#include <QTest>
+
+#include "crypto/Random.h"
+#include "crypto/SymmetricCipher.h"
+
+Q_DECLARE_METATYPE(SymmetricCipher::Mode);
+
+/**
+ * Keys and payloads shared by the tests of the KDBX 4 payload streams.
+ */
+namespace HmacStreamTestData
+{
+    const QByteArray Key = QByteArray(32, '\x42');
+    const QByteArray HmacKey = QByteArray(64, '\x17');
+
+    inline QByteArray payload(int size)
+    {
+        // Half compressible, half random
+        QByteArray data = randomGen()->randomArray(size / 2);
+        while (data.size() < size) {
+            data.append("<Entry><String><Key>Title</Key><Value>Example</Value></String></Entry>");
+        }
+        data.resize(size);
+        return data;
+    }
+
+    /**
+     * Adds a row to the current test data table, whose first column has
+     * to be the number of threads, named after the case and that number.
+     */
+    inline QTestData& addRow(const char* name, int threads)
+    {
+        return QTest::addRow("%s, %d thread(s)", name, threads) << threads;
+    }
+} // namespace HmacStreamTestData
+
+#endif // KEEPASSXC_HMACSTREAMTESTDATA_H